@@ -30,9 +30,11 @@ for file in "$BENCHMARK_DIR"/*.state; do
         echo "Processing $file..."
     BASE_NAME=$(basename "$file" .state)
         
-        # Generate BTOR2 file using riscv_to_btor2
+        # Generate BTOR2 file using riscv_to_btor2, from the cache in
+        # $MODEL_CACHE if it is set
         btor2_file="$TEMP_DIR/$BASE_NAME.btor2"
-        ./bin/riscv_to_btor2 -p -n -1 "$file" > "$btor2_file"
+        ./bin/riscv_to_btor2 -p -n -1 ${MODEL_CACHE:+--cache-dir="$MODEL_CACHE"} \
+            "$file" > "$btor2_file"
         
         # Append the benchmark name to the log file
         echo -n "Benchmark: $BASE_NAME" >> "$LOG_FILE"
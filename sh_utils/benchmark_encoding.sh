@@ -0,0 +1,85 @@
+#!/bin/bash
+
+# Benchmarks the base and fullmem states with additional riscv_to_btor2
+# options, e.g. to compare two encodings:
+#   sh_utils/benchmark_encoding.sh shared --writeback=shared
+#   sh_utils/benchmark_encoding.sh chain --writeback=chain
+# or the number of commands per transition:
+#   for k in 1 2 4 8; do sh_utils/benchmark_encoding.sh k$k -k $k; done
+# or the memory initialisation, also on extended address spaces:
+#   sh_utils/benchmark_encoding.sh init_auto_a17 -a 17 --memory-init=auto
+# or the memory cell width:
+#   sh_utils/benchmark_encoding.sh cells64 --memory-cells=64
+# or the register file as one array:
+#   sh_utils/benchmark_encoding.sh reg_array --registers=array
+# or RV32 registers:
+#   sh_utils/benchmark_encoding.sh rv32 --xlen=32
+# or memory cells as single states if the footprint is small enough:
+#   sh_utils/benchmark_encoding.sh scalar512 --scalar-memory=512
+# or the smallest address width the program needs:
+#   sh_utils/benchmark_encoding.sh auto_width -a auto
+# or the pc bounded to the reachable commands:
+#   sh_utils/benchmark_encoding.sh pc_constraint --pc-constraint
+# or stopping when the program halts:
+#   sh_utils/benchmark_encoding.sh halt --halt
+# or only the counter, without the error detection:
+#   sh_utils/benchmark_encoding.sh counter_only --props=counter
+# or two harts on the same memory, the second starting as a copy of the first:
+#   sh_utils/benchmark_encoding.sh harts2 --harts=2
+# or counting loops jumped over up to 255 iterations at once:
+#   sh_utils/benchmark_encoding.sh accelerate8 --accelerate=8
+# or starting where 1000 concretely executed commands end:
+#   sh_utils/benchmark_encoding.sh fast_forward1000 --fast-forward=1000
+# or with the models of earlier runs taken from a cache:
+#   sh_utils/benchmark_encoding.sh cached --cache-dir=benchmark_files/model_cache
+
+# Check if an identifier is provided
+if [ $# -lt 1 ]; then
+    echo "Usage: $0 <identifier> [riscv_to_btor2 options]"
+    echo "Run from main directory!"
+    exit 1
+fi
+
+identifier=$1
+shift
+EMITTER_ARGS="$@"
+
+# Directories containing benchmark files
+BENCHMARK_DIRS="benchmark_files/base benchmark_files/fullmem"
+TEMP_DIR="benchmark_files/temp_files"
+# Log file to store timing results
+LOG_FILE="benchmark_files/bench_encoding_${identifier}.log"
+
+# btormc executable path
+BTORMC_EXECUTABLE="/home/moell/Documents/Bachelor-Thesis/boolector/build/bin/btormc"
+
+# Clear the log file if it exists
+> "$LOG_FILE"
+if [[ ! -d "$TEMP_DIR" ]]; then
+    mkdir -p "$TEMP_DIR"
+fi
+
+echo "Options: $EMITTER_ARGS" >> "$LOG_FILE"
+
+# Iterate over all files in the benchmark directories
+for dir in $BENCHMARK_DIRS; do
+    for file in "$dir"/*.state; do
+        if [[ -f "$file" ]]; then
+            echo "Processing $file..."
+            BASE_NAME=$(basename "$file" .state)
+
+            # Generate BTOR2 file using riscv_to_btor2
+            btor2_file="$TEMP_DIR/${BASE_NAME}_${identifier}.btor2"
+            ./bin/riscv_to_btor2 -p -n -1 $EMITTER_ARGS "$file" > "$btor2_file"
+
+            # Append the benchmark name and model size to the log file
+            echo -n "Benchmark: $BASE_NAME" >> "$LOG_FILE"
+            echo -n " Lines: $(grep -vc '^;' "$btor2_file")" >> "$LOG_FILE"
+            # Run btormc and measure the time
+            { time "$BTORMC_EXECUTABLE" -kmax 10000 --trace-gen 0 "$btor2_file"; } 2>> "$LOG_FILE"
+            echo "" >> "$LOG_FILE"
+        fi
+    done
+done
+
+echo "Benchmarking encoding completed. Results saved in $LOG_FILE."
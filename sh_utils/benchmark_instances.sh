@@ -0,0 +1,51 @@
+#!/bin/bash
+
+# Benchmarks each family of base states, e.g. add_0256 ... add_2048, as one
+# multi-instance model instead of one model per state:
+#   sh_utils/benchmark_instances.sh instances
+#   sh_utils/benchmark_instances.sh instances_regions --memory-regions
+
+# Check if an identifier is provided
+if [ $# -lt 1 ]; then
+    echo "Usage: $0 <identifier> [riscv_to_btor2 options]"
+    echo "Run from main directory!"
+    exit 1
+fi
+
+identifier=$1
+shift
+EMITTER_ARGS="$@"
+
+# Directory containing benchmark files
+BENCHMARK_DIR="benchmark_files/base"
+TEMP_DIR="benchmark_files/temp_files"
+# Log file to store timing results
+LOG_FILE="benchmark_files/bench_instances_${identifier}.log"
+
+# btormc executable path
+BTORMC_EXECUTABLE="/home/moell/Documents/Bachelor-Thesis/boolector/build/bin/btormc"
+
+# Clear the log file if it exists
+> "$LOG_FILE"
+if [[ ! -d "$TEMP_DIR" ]]; then
+    mkdir -p "$TEMP_DIR"
+fi
+
+echo "Options: $EMITTER_ARGS" >> "$LOG_FILE"
+
+# One model per family, the states of a family only differ in their registers
+for family in $(ls "$BENCHMARK_DIR"/*.state | xargs -n 1 basename | sed 's/_[0-9]*\.state$//' | sort -u); do
+    echo "Processing $family..."
+    btor2_file="$TEMP_DIR/${family}_instances_${identifier}.btor2"
+    ./bin/riscv_to_btor2 -p -n -1 $EMITTER_ARGS "$BENCHMARK_DIR/${family}"_*.state > "$btor2_file"
+
+    # Append the family name and model size to the log file
+    echo -n "Benchmark: $family" >> "$LOG_FILE"
+    echo -n " Instances: $(ls "$BENCHMARK_DIR/${family}"_*.state | wc -l)" >> "$LOG_FILE"
+    echo -n " Lines: $(grep -vc '^;' "$btor2_file")" >> "$LOG_FILE"
+    # Run btormc and measure the time
+    { time "$BTORMC_EXECUTABLE" -kmax 10000 --trace-gen 0 "$btor2_file"; } 2>> "$LOG_FILE"
+    echo "" >> "$LOG_FILE"
+done
+
+echo "Benchmarking instances completed. Results saved in $LOG_FILE."
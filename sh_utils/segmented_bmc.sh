@@ -0,0 +1,162 @@
+#!/bin/bash
+
+# Checks a long run as a chain of windows of a bounded number of commands.
+# The model of each window starts from the state the last one ended in:
+# btormc finds the counter_maxed witness at its end and restate_witness turns
+# it into the state of the next window. Any other bad ends the chain.
+# While btormc solves a window, the model of the next one is already emitted
+# from a concrete run of the window (--fast-forward). It is used if that run
+# did all commands of the window, as the window has only that run then.
+# Without btormc the concrete run stands in for it, so the chain ends at the
+# first command that needs a solver:
+#   sh_utils/segmented_bmc.sh -w 500 -m 20 benchmark_files/base/add_2048.state
+#   sh_utils/segmented_bmc.sh -w 200 benchmark_files/base/add_2048.state -k 2
+# The window end states are taken from the witnesses, so with symbolic values
+# only the run btormc chose is followed. With -k the window has to be a
+# multiple of it, as the counter only meets -n there.
+
+WINDOW=1000
+MAX_WINDOWS=10
+WORK_DIR=""
+while getopts ":w:m:d:" opt; do
+    case $opt in
+        w)
+            WINDOW=$OPTARG
+            ;;
+        m)
+            MAX_WINDOWS=$OPTARG
+            ;;
+        d)
+            WORK_DIR=$OPTARG
+            ;;
+        *)
+            echo "Invalid option: -$OPTARG" >&2
+            exit 1
+            ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+if [ $# -lt 1 ] || [[ "${1##*.}" != "state" ]]; then
+    echo "Usage: $0 [-w <commands per window>] [-m <max windows>]" \
+         "[-d <work dir>] <file>.state [riscv_to_btor2 options]"
+    echo "Run from main directory!"
+    exit 1
+fi
+if ! [[ "$WINDOW" =~ ^[0-9]+$ && "$MAX_WINDOWS" =~ ^[0-9]+$ ]] ||
+   [ "$WINDOW" -eq 0 ]; then
+    echo "Error: Window and max windows must be positive integers."
+    exit 1
+fi
+
+STATE_FILE=$1
+shift
+EMITTER_ARGS="$@"
+BASE_NAME=$(basename "$STATE_FILE" .state)
+WORK_DIR=${WORK_DIR:-benchmark_files/temp_files/segmented_${BASE_NAME}}
+
+EMITTER="bin/riscv_to_btor2"
+RESTATE="bin/restate_witness"
+# btormc executable path, $BTORMC or the one in PATH are taken before
+BTORMC_EXECUTABLE="/home/moell/Documents/Bachelor-Thesis/boolector/build/bin/btormc"
+if [[ -n "$BTORMC" ]]; then
+    BTORMC_EXECUTABLE=$BTORMC
+elif [[ ! -x "$BTORMC_EXECUTABLE" ]]; then
+    BTORMC_EXECUTABLE=$(command -v btormc)
+fi
+if [[ ! -x "$EMITTER" || ! -x "$RESTATE" || ! -f "$STATE_FILE" ]]; then
+    echo "Error: riscv_to_btor2, restate_witness or the state is missing."
+    exit 1
+fi
+if [[ ! -x "$BTORMC_EXECUTABLE" ]]; then
+    echo "No btormc found, windows are run concretely instead."
+    BTORMC_EXECUTABLE=""
+fi
+
+rm -rf "$WORK_DIR"
+mkdir -p "$WORK_DIR"
+
+now_ms() {
+    echo $(( $(date +%s%N) / 1000000 ))
+}
+
+counter_start() {
+    # Initial value of the counter of a model, the commands fast-forwarded
+    awk '/Counter for executed/ { getline; print ($2 == "constd") ? $4 : 0;
+                                  exit }' "$1"
+}
+
+emit_speculation() {
+    # Model of the window after the one from state $1, from its concrete run
+    "$EMITTER" -p -n $((2 * WINDOW)) --fast-forward=$WINDOW \
+        --fast-forward-state="$2" $EMITTER_ARGS "$1" > "$3" 2> "$3.log"
+}
+
+state="$STATE_FILE"
+model="$WORK_DIR/window_1.btor2"
+"$EMITTER" -p -n $WINDOW $EMITTER_ARGS "$state" > "$model" || exit 1
+depth=0
+start_total=$(now_ms)
+
+for ((i = 1; i <= MAX_WINDOWS; i++)); do
+    next_state="$WORK_DIR/window_$((i + 1)).state"
+    next_model="$WORK_DIR/window_$((i + 1)).btor2"
+    witness="$WORK_DIR/window_$i.witness"
+    lines=$(grep -vc '^;' "$model")
+    start=$(now_ms)
+
+    if [[ -z "$BTORMC_EXECUTABLE" ]]; then
+        emit_speculation "$state" "$next_state" "$next_model"
+        executed=$(counter_start "$next_model")
+        echo "Window $i: $lines lines, run concretely in" \
+             "$(( $(now_ms) - start )) ms"
+        depth=$((depth + executed))
+        if [ "$executed" -ne "$WINDOW" ]; then
+            sed 's/^Fast-forward/Concrete run/' "$next_model.log"
+            echo "A solver is needed from here on."
+            break
+        fi
+        state="$next_state"
+        model="$next_model"
+        continue
+    fi
+
+    ( "$BTORMC_EXECUTABLE" -kmax $WINDOW --trace-gen-full "$model" \
+          > "$witness" ) &
+    solver=$!
+    emit_speculation "$state" "$next_state" "$next_model"
+    speculated=$(( $(now_ms) - start ))
+    wait $solver
+    solved=$(( $(now_ms) - start ))
+
+    if [[ "$(head -n 1 "$witness")" != "sat" ]]; then
+        echo "Window $i: $lines lines, no bad within $solved ms."
+        echo "The counter bad has to be emitted to chain the windows."
+        break
+    fi
+    bad=$(sed -n '2s/^b\([0-9]*\).*/\1/p' "$witness")
+    bad_name=$(grep -E '^[0-9]+ bad ' "$model" | sed -n "$((bad + 1))p" |
+               awk '{ print $4 }')
+    counter=$(grep 'iterations_counter#' "$witness" | tail -n 1 |
+              awk '{ print $2 }')
+    executed=$(( 2#$counter - $(counter_start "$model") ))
+    depth=$((depth + executed))
+    echo "Window $i: $lines lines, solved in $solved ms, next model" \
+         "emitted in $speculated ms"
+    if [[ "$bad_name" != "counter_maxed" ]]; then
+        echo "Bad $bad_name after $depth commands, see $witness."
+        break
+    fi
+
+    if [ "$(counter_start "$next_model")" -ne "$WINDOW" ]; then
+        # The concrete run stopped early, the witness decides the end state
+        "$RESTATE" -o "$next_state" "$witness" || exit 1
+        "$EMITTER" -p -n $WINDOW $EMITTER_ARGS "$next_state" \
+            > "$next_model" || exit 1
+    fi
+    state="$next_state"
+    model="$next_model"
+done
+
+echo "Total depth: $depth commands in $(( $(now_ms) - start_total )) ms," \
+     "files in $WORK_DIR."
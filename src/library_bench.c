@@ -0,0 +1,251 @@
+#include "./riscv_btor2.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Compares converting states within one process through the library with
+ * starting riscv_to_btor2 for every case, as the benchmark scripts do. Each
+ * state file is one case, the options after -- are the ones of the model.
+ * With -w the witnesses are restated as well, in the process and by
+ * restate_witness. The outputs of both ways have to be the same.
+ */
+
+typedef struct text {
+  char *data;
+  size_t length;
+} text;
+
+static bool read_text(const char *path, text *t) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "Failed to open file: %s\n", path);
+    return false;
+  }
+  t->data = NULL;
+  t->length = 0;
+  FILE *copy = open_memstream(&t->data, &t->length);
+  char buff[65536];
+  size_t n;
+  while (copy && (n = fread(buff, 1, sizeof(buff), f)) > 0) {
+    fwrite(buff, 1, n, copy);
+  }
+  fclose(f);
+  if (!copy) {
+    return false;
+  }
+  fclose(copy);
+  return true;
+}
+
+static double seconds_since(struct timespec *start) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static bool run_tool(char **args, text *out) {
+  // What the tool prints to stdout, its exit status has to be 0
+  int pipe_fds[2];
+  if (pipe(pipe_fds)) {
+    return false;
+  }
+  pid_t child = fork();
+  if (child < 0) {
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    return false;
+  }
+  if (child == 0) {
+    dup2(pipe_fds[1], STDOUT_FILENO);
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    execv(args[0], args);
+    fprintf(stderr, "Failed to start %s\n", args[0]);
+    _exit(127);
+  }
+  close(pipe_fds[1]);
+  out->data = NULL;
+  out->length = 0;
+  FILE *copy = open_memstream(&out->data, &out->length);
+  char buff[65536];
+  ssize_t n;
+  while ((n = read(pipe_fds[0], buff, sizeof(buff))) > 0) {
+    if (copy) {
+      fwrite(buff, 1, n, copy);
+    }
+  }
+  close(pipe_fds[0]);
+  if (copy) {
+    fclose(copy);
+  }
+  int status;
+  waitpid(child, &status, 0);
+  return copy && WIFEXITED(status) && !WEXITSTATUS(status);
+}
+
+static bool emit_in_process(text *source, int n_options, char **options,
+                            text *out) {
+  // getopt reorders its arguments, so every call gets a fresh array
+  char **args = malloc((n_options + 2) * sizeof(char *));
+  args[0] = "riscv_to_btor2";
+  memcpy(args + 1, options, n_options * sizeof(char *));
+  args[n_options + 1] = NULL;
+  bool emitted = set_model_options(n_options + 1, args, NULL, NULL) >= 0;
+  free(args);
+  state *s = create_new_state();
+  emitted = emitted && s && load_state_buffer(source->data, source->length, s);
+  writer *w = emitted ? open_memory_writer() : NULL;
+  if (!w) {
+    if (s) {
+      kill_state(s);
+    }
+    return false;
+  }
+  emitted = emit_model(w, &s, NULL, 1);
+  out->data = take_writer_buffer(w, &out->length);
+  kill_state(s);
+  return emitted && out->data;
+}
+
+static bool restate_in_process(text *witness, text *out) {
+  state *s = parse_witness_buffer(witness->data, witness->length, -1, false);
+  if (!s) {
+    return false;
+  }
+  out->data = NULL;
+  out->length = 0;
+  FILE *copy = open_memstream(&out->data, &out->length);
+  if (!copy) {
+    kill_state(s);
+    return false;
+  }
+  echo_and_kill_state_keep_seed(s, copy, NULL);
+  fclose(copy);
+  return true;
+}
+
+static bool same_text(text *a, text *b) {
+  return a->length == b->length && !memcmp(a->data, b->data, a->length);
+}
+
+int main(int argc, char *argv[]) {
+  int runs = 10;
+  char **witnesses = calloc(argc, sizeof(char *));
+  int n_witnesses = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "+r:w:")) != -1) {
+    switch (opt) {
+    case 'r': // runs of every case
+      runs = atoi(optarg);
+      if (runs < 1) {
+        fprintf(stderr, "Runs must be a positive integer.\n");
+        return 1;
+      }
+      break;
+    case 'w': // witness to restate
+      witnesses[n_witnesses++] = optarg;
+      break;
+    default:
+      fprintf(stderr,
+              "Usage: %s [-r <runs>] [-w <witness file> ...] "
+              "<sourcefile>.state ... [-- <riscv_to_btor2 options>]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+  int n_states = 0;
+  while (optind + n_states < argc && strcmp(argv[optind + n_states], "--")) {
+    n_states++;
+  }
+  char **state_files = argv + optind;
+  int first_option = optind + n_states + (optind + n_states < argc);
+  char **options = argv + first_option;
+  int n_options = argc - first_option;
+  if (!n_states && !n_witnesses) {
+    fprintf(stderr, "Expected state files or witnesses to convert.\n");
+    return 1;
+  }
+
+  // The tools are the ones built next to this benchmark
+  char tool_dir[4096] = "";
+  char *slash = strrchr(argv[0], '/');
+  if (slash) {
+    snprintf(tool_dir, sizeof(tool_dir), "%.*s/", (int)(slash - argv[0]),
+             argv[0]);
+  }
+  char emitter[4096];
+  char restater[4096];
+  snprintf(emitter, sizeof(emitter), "%sriscv_to_btor2", tool_dir);
+  snprintf(restater, sizeof(restater), "%srestate_witness", tool_dir);
+
+  char **emitter_args = calloc(n_options + 4, sizeof(char *));
+  emitter_args[0] = emitter;
+  memcpy(emitter_args + 1, options, n_options * sizeof(char *));
+  emitter_args[n_options + 1] = "-p";
+  char *restater_args[] = {restater, "-p", NULL, NULL};
+
+  printf("%-40s %12s %12s %8s\n", "case", "library [s]", "fork/exec [s]",
+         "speedup");
+  bool all_same = true;
+  double library_total = 0;
+  double tool_total = 0;
+  for (int i = 0; i < n_states + n_witnesses; i++) {
+    bool is_state = i < n_states;
+    char *path = is_state ? state_files[i] : witnesses[i - n_states];
+    text source;
+    if (!read_text(path, &source)) {
+      return 1;
+    }
+    double library_time = 0;
+    double tool_time = 0;
+    for (int run = 0; run < runs; run++) {
+      text library_out;
+      text tool_out;
+      struct timespec start;
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      bool converted = is_state ? emit_in_process(&source, n_options,
+                                                  options, &library_out)
+                                : restate_in_process(&source, &library_out);
+      library_time += seconds_since(&start);
+      if (!converted) {
+        fprintf(stderr, "Library failed on %s\n", path);
+        return 1;
+      }
+
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      if (is_state) {
+        emitter_args[n_options + 2] = path;
+        converted = run_tool(emitter_args, &tool_out);
+      } else {
+        restater_args[2] = path;
+        converted = run_tool(restater_args, &tool_out);
+      }
+      tool_time += seconds_since(&start);
+      if (!converted) {
+        fprintf(stderr, "Tool failed on %s\n", path);
+        return 1;
+      }
+      if (!same_text(&library_out, &tool_out)) {
+        fprintf(stderr, "Outputs differ on %s\n", path);
+        all_same = false;
+      }
+      free(library_out.data);
+      free(tool_out.data);
+    }
+    free(source.data);
+    printf("%-40s %12.6f %12.6f %7.2fx\n", path, library_time / runs,
+           tool_time / runs, tool_time / library_time);
+    library_total += library_time;
+    tool_total += tool_time;
+  }
+  printf("%-40s %12.6f %12.6f %7.2fx\n", "total", library_total / runs,
+         tool_total / runs, tool_total / library_total);
+  free(emitter_args);
+  free(witnesses);
+  return all_same ? 0 : 1;
+}
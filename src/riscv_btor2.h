@@ -0,0 +1,18 @@
+#include "./utils/model.h"
+#include "./utils/state.h"
+#include "./utils/witness.h"
+#include "./utils/writer.h"
+
+#ifndef RISCV_BTOR2
+#define RISCV_BTOR2
+
+// What lib/libriscv_btor2.a offers to other programs, e.g. for many models:
+//   set_model_options(argc, argv, NULL, NULL);
+//   state *s = create_new_state();
+//   load_state_buffer(text, length, s);
+//   writer *w = open_memory_writer(); // or open_sink_writer(sink, context)
+//   emit_model(w, &s, NULL, 1);
+//   char *model = take_writer_buffer(w, &model_length);
+// parse_witness_buffer reads the state a witness of such a model ends in.
+
+#endif // RISCV_BTOR2
@@ -1,3 +1,4 @@
+#include "./utils/decoder.h"
 #include "./utils/state.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -40,6 +41,7 @@ uint64_t rand_uint64_t() {
 int main(int argc, char *argv[]) {
 
   unsigned int seed = time(NULL); // Default seed value
+  int xlen = 64;                  // register width
 
   bool to_stdout = false;
   char *target_path = malloc(13 * sizeof(char)); // Default target path
@@ -51,7 +53,7 @@ int main(int argc, char *argv[]) {
   strcpy(target_path, "fuzzed.state");
   int opt;
 
-  while ((opt = getopt(argc, argv, "po:s:")) != -1) {
+  while ((opt = getopt(argc, argv, "po:s:x:")) != -1) {
     switch (opt) {
 
     case 's': // seed
@@ -60,6 +62,13 @@ int main(int argc, char *argv[]) {
     case 'p':
       to_stdout = true;
       break;
+    case 'x': // register width
+      xlen = atoi(optarg);
+      if (xlen != 32 && xlen != 64) {
+        fprintf(stderr, "Xlen must be 32 or 64.\n");
+        return 1;
+      }
+      break;
     case 'o':
       target_path =
           realloc(target_path, strlen(optarg) + 1); // +1 for null terminator
@@ -73,7 +82,9 @@ int main(int argc, char *argv[]) {
       fprintf(stderr, "Unknown option: %c\n", optopt);
       return 1;
     default:
-      fprintf(stderr, "Usage: %s [-p] [-o <output file>] [-s <seed(int)>]\n",
+      fprintf(stderr,
+              "Usage: %s [-p] [-o <output file>] [-s <seed(int)>] "
+              "[-x <xlen(32|64)>]\n",
               argv[0]);
       return 1;
     }
@@ -94,6 +105,7 @@ int main(int argc, char *argv[]) {
   }
 
   state *s = create_new_state();
+  s->xlen = xlen;
   s->pc =
       rand() % MEMORY_ADDRESSES; // Random pc value in the first 256 addresses
 
@@ -117,6 +129,9 @@ int main(int argc, char *argv[]) {
   uint32_t sixth_bit_for_shift =
       ((rand() % 2) << 25); // Random 6. bit for shift commands, where lowest
                             // bit of funct7 is part of shift amount
+  if (xlen == 32) {
+    sixth_bit_for_shift = 0; // shamt has only 5 bits
+  }
 
   uint64_t immediate = rand_uint64_t(); // Random immediate value
 
@@ -175,6 +190,10 @@ int main(int argc, char *argv[]) {
   int command_picker =
       rand() % (sizeof(command_base) /
                 sizeof(command_base[0])); // Randomly pick a command
+  while (xlen == 32 &&
+         is_rv64_only_command(decode_command(command_base[command_picker]))) {
+    command_picker = rand() % (sizeof(command_base) / sizeof(command_base[0]));
+  }
   uint32_t command = command_base[command_picker];
 
   bool r_type = false;     // R-type commands
@@ -405,6 +424,9 @@ int main(int argc, char *argv[]) {
   }
 
   set_word(s, s->pc, command); // Set the command at the pc address
+  for (size_t i = 0; xlen == 32 && i < 32; i++) {
+    s->regs_values[i] &= 0xFFFFFFFF; // registers only hold 32 bits
+  }
 
   echo_and_kill_state_keep_seed(s, f,
                                 &seed); // Print the state to the file or stdout
@@ -0,0 +1,176 @@
+#include "./cone.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_TOKENS 8 // id, op, up to five operands and a symbol
+
+typedef struct btor_line {
+  char *buffer; // the tokens point into it
+  bool is_node;  // comments and empty lines are written back as they are
+  long id;
+  char *tokens[MAX_TOKENS];
+  int n_tokens;
+  bool is_ref[MAX_TOKENS]; // token names another node, possibly negated
+} btor_line;
+
+static bool is_one_of(const char *op, const char *const *ops) {
+  for (size_t i = 0; ops[i]; i++) {
+    if (!strcmp(op, ops[i])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static int operand_refs(btor_line *line) {
+  // Number of tokens after the op that name nodes, the rest are literals or
+  // the symbol. Negative for array sorts, whose sorts follow "array".
+  const char *op = line->tokens[1];
+  const char *sort_only[] = {"const", "constd", "consth", "zero", "one",
+                             "ones",  "state",  "input",  NULL};
+  const char *unary[] = {"not",    "inc",    "dec",   "neg",  "redand",
+                         "redor",  "redxor", "slice", "uext", "sext",
+                         NULL};
+  const char *ternary[] = {"ite", "write", NULL};
+  const char *properties[] = {"bad", "constraint", "fair", "output", NULL};
+  if (!strcmp(op, "sort")) {
+    return line->n_tokens > 2 && !strcmp(line->tokens[2], "array") ? -2 : 0;
+  } else if (is_one_of(op, sort_only) || is_one_of(op, properties)) {
+    return 1;
+  } else if (is_one_of(op, unary)) {
+    return 2;
+  } else if (is_one_of(op, ternary)) {
+    return 4;
+  }
+  return 3; // binary, init and next
+}
+
+static bool parse_line(char *text, btor_line *line) {
+  line->buffer = text;
+  line->is_node = !(text[0] == ';' || text[0] == '\n' || text[0] == '\0');
+  line->n_tokens = 0;
+  if (!line->is_node) {
+    return true;
+  }
+  char *save;
+  char *token = strtok_r(text, " \n", &save);
+  while (token && line->n_tokens < MAX_TOKENS) {
+    line->tokens[line->n_tokens] = token;
+    line->is_ref[line->n_tokens] = false;
+    line->n_tokens++;
+    token = strtok_r(NULL, " \n", &save);
+  }
+  if (line->n_tokens < 2 || token) {
+    return false;
+  }
+  line->id = strtol(line->tokens[0], NULL, 10);
+  int refs = operand_refs(line);
+  int first = 2;
+  if (refs < 0) { // array sort, the index and element sorts follow "array"
+    first = 3;
+    refs = -refs;
+  }
+  if (first + refs > line->n_tokens) {
+    return false;
+  }
+  for (int i = first; i < first + refs; i++) {
+    line->is_ref[i] = true;
+  }
+  return line->id > 0;
+}
+
+static bool is_root(btor_line *line) {
+  const char *roots[] = {"sort", "state", "init",   "next",
+                         "bad",  "fair",  "output", "constraint", NULL};
+  return is_one_of(line->tokens[1], roots);
+}
+
+long write_cone_of_influence(FILE *source, writer *target) {
+  size_t n_lines = 0;
+  size_t capacity = 0;
+  btor_line *lines = NULL;
+  char *text = NULL;
+  size_t length = 0;
+  long max_id = 0;
+  bool valid = true;
+  while (getline(&text, &length, source) != -1) {
+    if (n_lines == capacity) {
+      capacity = capacity ? 2 * capacity : 1024;
+      lines = realloc(lines, capacity * sizeof(btor_line));
+    }
+    btor_line *line = &lines[n_lines];
+    n_lines++;
+    valid &= parse_line(strdup(text), line);
+    if (line->is_node && line->id > max_id) {
+      max_id = line->id;
+    }
+  }
+  free(text);
+
+  // Operands always come before their users, so one pass down the ids
+  // marks the whole cone
+  btor_line **by_id = calloc(max_id + 1, sizeof(btor_line *));
+  bool *keep = calloc(max_id + 1, sizeof(bool));
+  long *new_id = calloc(max_id + 1, sizeof(long));
+  for (size_t i = 0; i < n_lines && valid; i++) {
+    if (lines[i].is_node) {
+      by_id[lines[i].id] = &lines[i];
+      keep[lines[i].id] = is_root(&lines[i]);
+    }
+  }
+  for (long id = max_id; id > 0 && valid; id--) {
+    if (!by_id[id] || !keep[id]) {
+      continue;
+    }
+    for (int i = 0; i < by_id[id]->n_tokens; i++) {
+      if (by_id[id]->is_ref[i]) {
+        long ref = labs(strtol(by_id[id]->tokens[i], NULL, 10));
+        valid &= ref > 0 && ref < id && by_id[ref];
+        if (valid) {
+          keep[ref] = true;
+        }
+      }
+    }
+  }
+
+  long removed = 0;
+  long next_id = 1;
+  for (long id = 1; id <= max_id && valid; id++) {
+    if (by_id[id] && keep[id]) {
+      new_id[id] = next_id++;
+    } else if (by_id[id]) {
+      removed++;
+    }
+  }
+  for (size_t i = 0; i < n_lines && valid; i++) {
+    btor_line *line = &lines[i];
+    if (!line->is_node) {
+      bwrite(target, line->buffer, strlen(line->buffer));
+      continue;
+    }
+    if (!keep[line->id]) {
+      continue;
+    }
+    bprintf(target, "%ld %s", new_id[line->id], line->tokens[1]);
+    for (int j = 2; j < line->n_tokens; j++) {
+      if (line->is_ref[j]) {
+        long ref = strtol(line->tokens[j], NULL, 10);
+        bprintf(target, " %ld", ref < 0 ? -new_id[-ref] : new_id[ref]);
+      } else {
+        bprintf(target, " %s", line->tokens[j]);
+      }
+    }
+    bprintf(target, "\n");
+  }
+
+  for (size_t i = 0; i < n_lines; i++) {
+    free(lines[i].buffer);
+  }
+  free(lines);
+  free(by_id);
+  free(keep);
+  free(new_id);
+  return valid ? removed : -1;
+}
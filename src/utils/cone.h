@@ -0,0 +1,14 @@
+#include "./writer.h"
+#include <stdio.h>
+
+#ifndef CONE
+#define CONE
+
+// Copies the BTOR2 model from source to target with only the nodes that the
+// bad properties, constraints, outputs and states depend on. Every state is
+// kept with its init and next, so witnesses keep their lines. The kept nodes
+// are numbered again from 1, sorts and comments are always kept.
+// Returns the number of nodes removed, -1 if a line could not be parsed.
+long write_cone_of_influence(FILE *source, writer *target);
+
+#endif // CONE
@@ -0,0 +1,211 @@
+#include "./decoder.h"
+#include "./memory_table.h"
+#include "./state.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+const char *command_names[COMMAND_COUNT] = {
+    "LUI",   "AUIPC", "JAL",   "JALR",  "BEQ",   "BNE",  "BLT",
+    "BGE",   "BLTU",  "BGEU",  "LB",    "LH",    "LW",   "LBU",
+    "LHU",   "SB",    "SH",    "SW",    "ADDI",  "SLTI", "SLTIU",
+    "XORI",  "ORI",   "ANDI",  "ADD",   "SUB",   "SLL",  "SLT",
+    "SLTU",  "XOR",   "SRL",   "SRA",   "OR",    "AND",  "LWU",
+    "LD",    "SD",    "SLLI",  "SRLI",  "SRAI",  "ADDIW", "SLLIW",
+    "SRLIW", "SRAIW", "ADDW",  "SUBW",  "SLLW",  "SRLW", "SRAW"};
+
+// Mirrors the command checks of the BTOR2 model: only opcode, funct3 and the
+// second highest bit of funct7 are looked at, so both agree on every word.
+command_index decode_command(uint32_t command) {
+  uint8_t opcode = command & 0x7f;
+  uint8_t funct3 = (command >> 12) & 0x7;
+  bool funct7_bit = (command >> 30) & 0x1;
+
+  switch (opcode) {
+  case 0x37:
+    return CMD_LUI;
+  case 0x17:
+    return CMD_AUIPC;
+  case 0x6f:
+    return CMD_JAL;
+  case 0x67:
+    return funct3 == 0 ? CMD_JALR : CMD_UNKNOWN;
+  case 0x63: {
+    const command_index branches[8] = {
+        CMD_BEQ, CMD_BNE,  CMD_UNKNOWN, CMD_UNKNOWN,
+        CMD_BLT, CMD_BGE,  CMD_BLTU,    CMD_BGEU};
+    return branches[funct3];
+  }
+  case 0x03: {
+    const command_index loads[8] = {CMD_LB,  CMD_LH,  CMD_LW,  CMD_LD,
+                                    CMD_LBU, CMD_LHU, CMD_LWU, CMD_UNKNOWN};
+    return loads[funct3];
+  }
+  case 0x23: {
+    const command_index stores[8] = {CMD_SB,      CMD_SH,      CMD_SW,
+                                     CMD_SD,      CMD_UNKNOWN, CMD_UNKNOWN,
+                                     CMD_UNKNOWN, CMD_UNKNOWN};
+    return stores[funct3];
+  }
+  case 0x13: {
+    const command_index math_i[8] = {CMD_ADDI, CMD_SLLI, CMD_SLTI, CMD_SLTIU,
+                                     CMD_XORI, CMD_SRLI, CMD_ORI,  CMD_ANDI};
+    if (funct3 == 5 && funct7_bit) {
+      return CMD_SRAI;
+    }
+    return math_i[funct3];
+  }
+  case 0x33: {
+    const command_index math_reg[8] = {CMD_ADD, CMD_SLL, CMD_SLT, CMD_SLTU,
+                                       CMD_XOR, CMD_SRL, CMD_OR,  CMD_AND};
+    if (funct3 == 0 && funct7_bit) {
+      return CMD_SUB;
+    }
+    if (funct3 == 5 && funct7_bit) {
+      return CMD_SRA;
+    }
+    return math_reg[funct3];
+  }
+  case 0x1b:
+    if (funct3 == 0) {
+      return CMD_ADDIW;
+    } else if (funct3 == 1) {
+      return CMD_SLLIW;
+    } else if (funct3 == 5) {
+      return funct7_bit ? CMD_SRAIW : CMD_SRLIW;
+    }
+    return CMD_UNKNOWN;
+  case 0x3b:
+    if (funct3 == 0) {
+      return funct7_bit ? CMD_SUBW : CMD_ADDW;
+    } else if (funct3 == 1) {
+      return CMD_SLLW;
+    } else if (funct3 == 5) {
+      return funct7_bit ? CMD_SRAW : CMD_SRLW;
+    }
+    return CMD_UNKNOWN;
+  default:
+    return CMD_UNKNOWN;
+  }
+}
+
+bool is_rv64_only_command(command_index command) {
+  return command >= CMD_LWU && command != CMD_SLLI && command != CMD_SRLI &&
+         command != CMD_SRAI;
+}
+
+void disassemble_command(uint32_t command, char *buffer, size_t size) {
+  command_index index = decode_command(command);
+  if (index == CMD_UNKNOWN) {
+    snprintf(buffer, size, "unknown 0x%08x", command);
+    return;
+  }
+  const char *name = command_names[index];
+  uint8_t opcode = command & 0x7f;
+  uint8_t rd = (command >> 7) & 0x1f;
+  uint8_t rs1 = (command >> 15) & 0x1f;
+  uint8_t rs2 = (command >> 20) & 0x1f;
+  int32_t imm_i = (int32_t)command >> 20;
+  int32_t imm_s = ((int32_t)command >> 25) << 5 | ((command >> 7) & 0x1f);
+  int32_t imm_b = ((int32_t)command >> 31) << 12 | ((command >> 7) & 1) << 11 |
+                  ((command >> 25) & 0x3f) << 5 | ((command >> 8) & 0xf) << 1;
+  int32_t imm_j = ((int32_t)command >> 31) << 20 |
+                  ((command >> 12) & 0xff) << 12 |
+                  ((command >> 20) & 1) << 11 | ((command >> 21) & 0x3ff) << 1;
+
+  switch (opcode) {
+  case 0x37: // LUI, AUIPC
+  case 0x17:
+    snprintf(buffer, size, "%s x%d, 0x%x", name, rd, command >> 12);
+    break;
+  case 0x6f:
+    snprintf(buffer, size, "%s x%d, %d", name, rd, imm_j);
+    break;
+  case 0x67:
+  case 0x03: // JALR and loads
+    snprintf(buffer, size, "%s x%d, %d(x%d)", name, rd, imm_i, rs1);
+    break;
+  case 0x23:
+    snprintf(buffer, size, "%s x%d, %d(x%d)", name, rs2, imm_s, rs1);
+    break;
+  case 0x63:
+    snprintf(buffer, size, "%s x%d, x%d, %d", name, rs1, rs2, imm_b);
+    break;
+  case 0x13:
+  case 0x1b: // shifts by immediate only take shamt
+    if (index == CMD_SLLI || index == CMD_SRLI || index == CMD_SRAI ||
+        index == CMD_SLLIW || index == CMD_SRLIW || index == CMD_SRAIW) {
+      imm_i &= opcode == 0x13 ? 0x3f : 0x1f;
+    }
+    snprintf(buffer, size, "%s x%d, x%d, %d", name, rd, rs1, imm_i);
+    break;
+  default: // register commands
+    snprintf(buffer, size, "%s x%d, x%d, x%d", name, rd, rs1, rs2);
+    break;
+  }
+}
+
+bool is_command_at(state *s, uint64_t address, uint64_t address_limit) {
+  if (address + 4 > address_limit) {
+    return false;
+  }
+  uint32_t command = 0;
+  bool initialised = false;
+  for (int8_t j = 3; j >= 0; j--) {
+    initialised |= exists_address_in_table(s->memory, address + j);
+    command = command << 8;
+    command += get_memory_cell_content(s->memory, address + j);
+  }
+  return initialised && decode_command(command) != CMD_UNKNOWN;
+}
+
+bool find_code_region(state *s, uint64_t address_limit, uint64_t *start,
+                      uint64_t *end) {
+  if (!is_command_at(s, s->pc, address_limit)) {
+    return false;
+  }
+  *start = s->pc;
+  while (*start >= 4 && is_command_at(s, *start - 4, address_limit)) {
+    *start -= 4;
+  }
+  *end = s->pc + 4;
+  while (is_command_at(s, *end, address_limit)) {
+    *end += 4;
+  }
+  return true;
+}
+
+int find_used_commands(state *s, uint64_t address_limit,
+                       bool used[COMMAND_COUNT]) {
+  for (size_t i = 0; i < COMMAND_COUNT; i++) {
+    used[i] = false;
+  }
+  int found = 0;
+  uint64_t *addresses = get_initialised_adresses(s->memory);
+  uint64_t last_word = 0;
+  bool first = true;
+
+  for (size_t i = 1; i <= addresses[0]; i++) {
+    // every word that contains an initialised byte and could be fetched
+    uint64_t word = addresses[i] - ((addresses[i] - s->pc) % 4);
+    if ((!first && word == last_word) || word >= address_limit) {
+      continue;
+    }
+    first = false;
+    last_word = word;
+
+    uint32_t command = 0;
+    for (int8_t j = 3; j >= 0; j--) {
+      command = command << 8;
+      command += get_memory_cell_content(s->memory, word + j);
+    }
+    command_index found_command = decode_command(command);
+    if (found_command != CMD_UNKNOWN && !used[found_command]) {
+      used[found_command] = true;
+      found++;
+    }
+  }
+  free(addresses);
+  return found;
+}
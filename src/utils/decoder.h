@@ -0,0 +1,89 @@
+#include "./state.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef DECODER
+#define DECODER
+
+// Order is the same as the command checks in riscv_to_btor2, so the index can
+// be used as offset into them
+typedef enum command_index {
+  // RV32I
+  CMD_LUI,
+  CMD_AUIPC,
+  CMD_JAL,
+  CMD_JALR,
+  CMD_BEQ,
+  CMD_BNE,
+  CMD_BLT,
+  CMD_BGE,
+  CMD_BLTU,
+  CMD_BGEU,
+  CMD_LB,
+  CMD_LH,
+  CMD_LW,
+  CMD_LBU,
+  CMD_LHU,
+  CMD_SB,
+  CMD_SH,
+  CMD_SW,
+  CMD_ADDI,
+  CMD_SLTI,
+  CMD_SLTIU,
+  CMD_XORI,
+  CMD_ORI,
+  CMD_ANDI,
+  CMD_ADD,
+  CMD_SUB,
+  CMD_SLL,
+  CMD_SLT,
+  CMD_SLTU,
+  CMD_XOR,
+  CMD_SRL,
+  CMD_SRA,
+  CMD_OR,
+  CMD_AND,
+  // RV64I
+  CMD_LWU,
+  CMD_LD,
+  CMD_SD,
+  CMD_SLLI,
+  CMD_SRLI,
+  CMD_SRAI,
+  CMD_ADDIW,
+  CMD_SLLIW,
+  CMD_SRLIW,
+  CMD_SRAIW,
+  CMD_ADDW,
+  CMD_SUBW,
+  CMD_SLLW,
+  CMD_SRLW,
+  CMD_SRAW,
+  COMMAND_COUNT,
+  CMD_UNKNOWN = -1
+} command_index;
+
+extern const char *command_names[COMMAND_COUNT];
+
+command_index decode_command(uint32_t command);
+
+// True for RV64I commands that RV32I does not know. The shifts by immediate
+// exist in both, RV32I only has the lower 5 bits of shamt.
+bool is_rv64_only_command(command_index command);
+
+// Writes the command in assembly syntax, e.g. "ADDI x1, x2, -4" or
+// "LW x5, 8(x2)". Branch and jump offsets are relative to the command.
+void disassemble_command(uint32_t command, char *buffer, size_t size);
+
+// Marks every command found in an initialised, pc-aligned word of the state.
+// Returns the number of distinct commands found.
+int find_used_commands(state *s, uint64_t address_limit,
+                       bool used[COMMAND_COUNT]);
+
+// Finds the run of consecutive words around pc that all decode to known
+// commands. end is exclusive. Returns false if the word at pc is no command.
+bool find_code_region(state *s, uint64_t address_limit, uint64_t *start,
+                      uint64_t *end);
+
+#endif // DECODER
@@ -0,0 +1,298 @@
+#include "./execute.h"
+#include "./decoder.h"
+#include "./memory_table.h"
+#include "./state.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+static int64_t sign_extend(uint64_t value, int bits) {
+  uint64_t sign = (uint64_t)1 << (bits - 1);
+  value &= (sign << 1) - 1;
+  return (int64_t)(value ^ sign) - (int64_t)sign;
+}
+
+static uint64_t register_mask(int xlen) {
+  return xlen == 32 ? 0xffffffff : UINT64_MAX;
+}
+
+static int64_t to_signed(int xlen, uint64_t value) {
+  return xlen == 32 ? (int32_t)value : (int64_t)value;
+}
+
+static uint64_t wrap_address(uint64_t address_limit, int xlen,
+                             uint64_t address) {
+  return address_limit ? address % address_limit
+                       : address & register_mask(xlen);
+}
+
+uint64_t execute_command(command_index command, uint32_t word, uint64_t pc,
+                         uint64_t a, uint64_t b, int xlen) {
+  int64_t imm_i = sign_extend(word >> 20, 12);
+  int64_t imm_u = (int32_t)(word & 0xfffff000);
+  uint64_t shamt_i = imm_i & (xlen - 1);
+  uint64_t shamt_r = b & (xlen - 1);
+  uint64_t shamt_w = (word >> 20) & 0x1f;
+  uint64_t mask = register_mask(xlen);
+  uint64_t result = 0;
+  switch (command) {
+  case CMD_LUI:
+    result = imm_u;
+    break;
+  case CMD_AUIPC:
+    result = pc + imm_u;
+    break;
+  case CMD_JAL:
+  case CMD_JALR:
+    result = pc + 4;
+    break;
+  case CMD_ADDI:
+    result = a + imm_i;
+    break;
+  case CMD_SLTI:
+    result = to_signed(xlen, a) < imm_i;
+    break;
+  case CMD_SLTIU:
+    result = a < ((uint64_t)imm_i & mask);
+    break;
+  case CMD_XORI:
+    result = a ^ imm_i;
+    break;
+  case CMD_ORI:
+    result = a | imm_i;
+    break;
+  case CMD_ANDI:
+    result = a & imm_i;
+    break;
+  case CMD_SLLI:
+    result = a << shamt_i;
+    break;
+  case CMD_SRLI:
+    result = a >> shamt_i;
+    break;
+  case CMD_SRAI:
+    result = to_signed(xlen, a) >> shamt_i;
+    break;
+  case CMD_ADD:
+    result = a + b;
+    break;
+  case CMD_SUB:
+    result = a - b;
+    break;
+  case CMD_SLL:
+    result = a << shamt_r;
+    break;
+  case CMD_SLT:
+    result = to_signed(xlen, a) < to_signed(xlen, b);
+    break;
+  case CMD_SLTU:
+    result = a < b;
+    break;
+  case CMD_XOR:
+    result = a ^ b;
+    break;
+  case CMD_SRL:
+    result = a >> shamt_r;
+    break;
+  case CMD_SRA:
+    result = to_signed(xlen, a) >> shamt_r;
+    break;
+  case CMD_OR:
+    result = a | b;
+    break;
+  case CMD_AND:
+    result = a & b;
+    break;
+  case CMD_ADDIW:
+    result = (int32_t)(a + imm_i);
+    break;
+  case CMD_SLLIW:
+    result = (int32_t)((uint32_t)a << shamt_w);
+    break;
+  case CMD_SRLIW:
+    result = (int32_t)((uint32_t)a >> shamt_w);
+    break;
+  case CMD_SRAIW:
+    result = (int32_t)a >> shamt_w;
+    break;
+  case CMD_ADDW:
+    result = (int32_t)(a + b);
+    break;
+  case CMD_SUBW:
+    result = (int32_t)(a - b);
+    break;
+  case CMD_SLLW:
+    result = (int32_t)((uint32_t)a << (b & 0x1f));
+    break;
+  case CMD_SRLW:
+    result = (int32_t)((uint32_t)a >> (b & 0x1f));
+    break;
+  case CMD_SRAW:
+    result = (int32_t)a >> (b & 0x1f);
+    break;
+  default:
+    break;
+  }
+  return result & mask;
+}
+
+bool is_branch_taken(command_index command, uint64_t a, uint64_t b,
+                     int xlen) {
+  switch (command) {
+  case CMD_BEQ:
+    return a == b;
+  case CMD_BNE:
+    return a != b;
+  case CMD_BLT:
+    return to_signed(xlen, a) < to_signed(xlen, b);
+  case CMD_BGE:
+    return to_signed(xlen, a) >= to_signed(xlen, b);
+  case CMD_BLTU:
+    return a < b;
+  default:
+    return a >= b;
+  }
+}
+
+static bool read_register(state *s, uint8_t number, int xlen,
+                          uint64_t *value) {
+  if (is_register_symbolic(s, number)) {
+    return false;
+  }
+  *value = 0; // also x0 and uninitialised registers
+  if (number && is_register_initialised(s, number)) {
+    *value = s->regs_values[number] & register_mask(xlen);
+  }
+  return true;
+}
+
+static bool is_concrete(state *s, uint64_t address_limit, int xlen,
+                        uint64_t address, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    if (find_symbolic_range(s, wrap_address(address_limit, xlen,
+                                            address + i))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static uint64_t read_bytes(state *s, uint64_t address_limit, int xlen,
+                           uint64_t address, int bytes) {
+  uint64_t value = 0; // little endian
+  for (int i = bytes - 1; i >= 0; i--) {
+    value = value << 8;
+    value += get_memory_cell_content(
+        s->memory, wrap_address(address_limit, xlen, address + i));
+  }
+  return value;
+}
+
+static int access_bytes(command_index command) {
+  switch (command) {
+  case CMD_LB:
+  case CMD_LBU:
+  case CMD_SB:
+    return 1;
+  case CMD_LH:
+  case CMD_LHU:
+  case CMD_SH:
+    return 2;
+  case CMD_LW:
+  case CMD_LWU:
+  case CMD_SW:
+    return 4;
+  case CMD_LD:
+  case CMD_SD:
+    return 8;
+  default:
+    return 0;
+  }
+}
+
+bool find_step(state *s, uint64_t address_limit, int xlen,
+               concrete_step *step) {
+  uint64_t mask = register_mask(xlen);
+  uint64_t pc = s->pc;
+  step->command = CMD_UNKNOWN;
+  if (!is_concrete(s, address_limit, xlen, pc, 4)) {
+    return false; // the command is chosen by the solver
+  }
+  step->word = read_bytes(s, address_limit, xlen, pc, 4);
+  uint32_t word = step->word;
+  command_index command = decode_command(word);
+  if (command == CMD_UNKNOWN || (xlen == 32 && is_rv64_only_command(command))) {
+    return false;
+  }
+  step->command = command;
+  uint8_t opcode = word & 0x7f;
+  uint64_t a = 0;
+  uint64_t b = 0;
+  bool uses_rs1 = opcode != 0x37 && opcode != 0x17 && opcode != 0x6f;
+  bool uses_rs2 = opcode == 0x63 || opcode == 0x23 || opcode == 0x33 ||
+                  opcode == 0x3b;
+  if ((uses_rs1 && !read_register(s, (word >> 15) & 0x1f, xlen, &a)) ||
+      (uses_rs2 && !read_register(s, (word >> 20) & 0x1f, xlen, &b))) {
+    return false;
+  }
+  step->next_pc = (pc + 4) & mask;
+  step->address = 0;
+  step->bytes = access_bytes(command);
+  step->is_store = opcode == 0x23;
+  step->rd = opcode == 0x63 || opcode == 0x23 ? 0 : (word >> 7) & 0x1f;
+  step->value = 0;
+
+  if (opcode == 0x63) {
+    int64_t imm_b = sign_extend(((word >> 31) & 1) << 12 |
+                                    ((word >> 7) & 1) << 11 |
+                                    ((word >> 25) & 0x3f) << 5 |
+                                    ((word >> 8) & 0xf) << 1,
+                                13);
+    if (is_branch_taken(command, a, b, xlen)) {
+      step->next_pc = (pc + imm_b) & mask;
+    }
+  } else if (opcode == 0x23) {
+    int64_t imm_s = sign_extend(((word >> 25) << 5) | ((word >> 7) & 0x1f), 12);
+    step->address = (a + imm_s) & mask;
+    step->value = b;
+    if (!is_concrete(s, address_limit, xlen, step->address, step->bytes)) {
+      return false; // the symbolic range would still constrain it
+    }
+  } else if (opcode == 0x03) {
+    step->address = (a + sign_extend(word >> 20, 12)) & mask;
+    if (!is_concrete(s, address_limit, xlen, step->address, step->bytes)) {
+      return false;
+    }
+    uint64_t value =
+        read_bytes(s, address_limit, xlen, step->address, step->bytes);
+    if (command == CMD_LB || command == CMD_LH || command == CMD_LW) {
+      value = sign_extend(value, step->bytes * 8);
+    }
+    step->value = value & mask;
+  } else {
+    step->value = execute_command(command, word, pc, a, b, xlen);
+    if (command == CMD_JAL) {
+      int64_t imm_j = sign_extend(((word >> 31) & 1) << 20 |
+                                      ((word >> 12) & 0xff) << 12 |
+                                      ((word >> 20) & 1) << 11 |
+                                      ((word >> 21) & 0x3ff) << 1,
+                                  21);
+      step->next_pc = (pc + imm_j) & mask;
+    } else if (command == CMD_JALR) {
+      step->next_pc = (a + sign_extend(word >> 20, 12)) & ~(uint64_t)1 & mask;
+    }
+  }
+  return true;
+}
+
+void apply_step(state *s, uint64_t address_limit, int xlen,
+                concrete_step *step) {
+  for (int i = 0; step->is_store && i < step->bytes; i++) {
+    set_byte(s, wrap_address(address_limit, xlen, step->address + i),
+             (step->value >> (8 * i)) & 0xff);
+  }
+  if (step->rd) {
+    set_register(s, step->rd, step->value);
+    s->regs_symbolic[step->rd] = false;
+  }
+  set_pc(s, wrap_address(address_limit, xlen, step->next_pc));
+}
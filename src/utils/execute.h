@@ -0,0 +1,41 @@
+#include "./decoder.h"
+#include "./state.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef EXECUTE
+#define EXECUTE
+
+// What the command at the pc of a concrete state does. The next pc and the
+// address are register wide, before they are cut to the memory.
+typedef struct concrete_step {
+  uint32_t word;
+  command_index command; // CMD_UNKNOWN also for RV64I commands on RV32
+  uint64_t next_pc;
+  uint64_t address; // first byte loaded or stored
+  int bytes;        // loaded or stored, 0 for other commands
+  bool is_store;
+  uint8_t rd;     // written, 0 if none is
+  uint64_t value; // for rd or stored
+} concrete_step;
+
+// Value for rd of every command that neither accesses memory nor branches,
+// the same the model computes for registers of xlen bits
+uint64_t execute_command(command_index command, uint32_t word, uint64_t pc,
+                         uint64_t a, uint64_t b, int xlen);
+
+bool is_branch_taken(command_index command, uint64_t a, uint64_t b, int xlen);
+
+// Evaluates the command at the pc of s without changing s. Uninitialised
+// registers and memory are zero. An address_limit of 0 lets addresses wrap at
+// the register width instead. Returns false if the command is unknown, or
+// reads or stores over a value the solver chooses.
+bool find_step(state *s, uint64_t address_limit, int xlen,
+               concrete_step *step);
+
+// Writes rd or the stored bytes of a found step and moves the pc. A symbolic
+// rd becomes concrete.
+void apply_step(state *s, uint64_t address_limit, int xlen,
+                concrete_step *step);
+
+#endif // EXECUTE
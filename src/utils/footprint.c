@@ -0,0 +1,505 @@
+#include "./footprint.h"
+#include "./decoder.h"
+#include "./execute.h"
+#include "./memory_table.h"
+#include "./state.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_PAIRS 8 // per allowed register value, when combining two sets
+#define MAX_WORK (1 << 24) // register values visited before giving up
+#define CONTROL_SET_LIMIT 1024 // register values kept while finding pcs
+
+typedef struct value_set {
+  bool top; // any value
+  size_t n;
+  uint64_t *values; // sorted, without duplicates
+} value_set;
+
+typedef struct pc_state {
+  uint64_t pc;
+  value_set regs[32];
+  value_set accessed; // base addresses whose cells are already collected
+  bool queued;
+} pc_state;
+
+typedef struct footprint_run {
+  state *s;
+  uint64_t address_limit; // 0 wraps addresses with the registers
+  int xlen;
+  uint64_t mask; // register width
+  pc_state *states;
+  size_t n_states;
+  size_t *worklist;
+  size_t n_work;
+  size_t max_cells;
+  size_t set_limit; // registers with more values are unknown
+  size_t work;
+  bool control_only; // loads may read anywhere, only stores must be known
+  value_set cells;
+  value_set fetched;
+  value_set loaded;
+  value_set stored;
+  bool failed;
+} footprint_run;
+
+static void set_clear(value_set *set) {
+  free(set->values);
+  set->values = NULL;
+  set->n = 0;
+  set->top = false;
+}
+
+static void set_add(value_set *set, uint64_t value, size_t limit) {
+  if (set->top) {
+    return;
+  }
+  size_t low = 0;
+  size_t high = set->n;
+  while (low < high) { // position of the first value not below
+    size_t mid = (low + high) / 2;
+    if (set->values[mid] < value) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  if (low < set->n && set->values[low] == value) {
+    return;
+  }
+  if (set->n == limit) {
+    set_clear(set);
+    set->top = true;
+    return;
+  }
+  set->values = realloc(set->values, (set->n + 1) * sizeof(uint64_t));
+  memmove(set->values + low + 1, set->values + low,
+          (set->n - low) * sizeof(uint64_t));
+  set->values[low] = value;
+  set->n++;
+}
+
+static bool set_contains(value_set *set, uint64_t value) {
+  size_t low = 0;
+  size_t high = set->n;
+  while (low < high) {
+    size_t mid = (low + high) / 2;
+    if (set->values[mid] < value) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low < set->n && set->values[low] == value;
+}
+
+static bool set_join(value_set *target, value_set *source, size_t limit) {
+  // Returns true if target changed
+  if (target->top) {
+    return false;
+  }
+  if (source->top) {
+    set_clear(target);
+    target->top = true;
+    return true;
+  }
+  uint64_t *merged = malloc((target->n + source->n) * sizeof(uint64_t));
+  size_t n = 0;
+  size_t i = 0;
+  size_t j = 0;
+  while (i < target->n || j < source->n) {
+    if (j == source->n ||
+        (i < target->n && target->values[i] < source->values[j])) {
+      merged[n++] = target->values[i++];
+    } else if (i == target->n || source->values[j] < target->values[i]) {
+      merged[n++] = source->values[j++];
+    } else {
+      merged[n++] = target->values[i++];
+      j++;
+    }
+  }
+  if (n == target->n) {
+    free(merged);
+    return false;
+  }
+  set_clear(target);
+  if (n > limit) {
+    free(merged);
+    target->top = true;
+  } else {
+    target->n = n;
+    target->values = merged;
+  }
+  return true;
+}
+
+static void set_copy(value_set *target, value_set *source) {
+  target->top = source->top;
+  target->n = source->n;
+  target->values = NULL;
+  if (source->n) {
+    target->values = malloc(source->n * sizeof(uint64_t));
+    memcpy(target->values, source->values, source->n * sizeof(uint64_t));
+  }
+}
+
+static void regs_copy(value_set *target, value_set *source) {
+  for (size_t i = 0; i < 32; i++) {
+    set_copy(&target[i], &source[i]);
+  }
+}
+
+static void regs_clear(value_set *regs) {
+  for (size_t i = 0; i < 32; i++) {
+    set_clear(&regs[i]);
+  }
+}
+
+static uint64_t wrap_address(footprint_run *run, uint64_t address) {
+  return run->address_limit ? address % run->address_limit
+                            : address & run->mask;
+}
+
+static void add_cell(footprint_run *run, value_set *kind, uint64_t address) {
+  address = wrap_address(run, address);
+  set_add(&run->cells, address, run->max_cells);
+  set_add(kind, address, run->max_cells);
+  if (run->cells.top) {
+    run->failed = true; // too many cells
+  }
+}
+
+static void propagate(footprint_run *run, uint64_t pc, value_set *regs) {
+  // Joins regs into the state at pc, which is queued again if it changed
+  pc = wrap_address(run, pc);
+  size_t i = 0;
+  while (i < run->n_states && run->states[i].pc != pc) {
+    i++;
+  }
+  bool changed = false;
+  if (i == run->n_states) {
+    run->states =
+        realloc(run->states, (run->n_states + 1) * sizeof(pc_state));
+    run->worklist =
+        realloc(run->worklist, (run->n_states + 1) * sizeof(size_t));
+    run->states[i].pc = pc;
+    run->states[i].queued = false;
+    run->states[i].accessed = (value_set){0};
+    regs_copy(run->states[i].regs, regs);
+    run->n_states++;
+    changed = true;
+  } else {
+    for (size_t j = 0; j < 32; j++) {
+      changed |= set_join(&run->states[i].regs[j], &regs[j], run->set_limit);
+    }
+  }
+  if (changed && !run->states[i].queued) {
+    run->states[i].queued = true;
+    run->worklist[run->n_work] = i;
+    run->n_work++;
+  }
+}
+
+static int64_t sign_extend(uint64_t value, int bits) {
+  uint64_t sign = (uint64_t)1 << (bits - 1);
+  value &= (sign << 1) - 1;
+  return (int64_t)(value ^ sign) - (int64_t)sign;
+}
+
+static void step_branch(footprint_run *run, command_index command,
+                        uint32_t word, uint64_t pc, value_set *regs) {
+  // Follows both edges, each with the operand values that take it
+  int64_t imm_b = sign_extend(((word >> 31) & 1) << 12 |
+                                  ((word >> 7) & 1) << 11 |
+                                  ((word >> 25) & 0x3f) << 5 |
+                                  ((word >> 8) & 0xf) << 1,
+                              13);
+  uint8_t rs1 = (word >> 15) & 0x1f;
+  uint8_t rs2 = (word >> 20) & 0x1f;
+  value_set *a = &regs[rs1];
+  value_set *b = &regs[rs2];
+  value_set edges[2][32]; // taken, not taken
+  regs_copy(edges[0], regs);
+  regs_copy(edges[1], regs);
+  bool feasible[2] = {true, true};
+  if (!a->top && !b->top && a->n * b->n <= MAX_PAIRS * run->set_limit) {
+    value_set narrowed[2][2] = {{{0}}}; // [edge][operand]
+    for (size_t i = 0; i < a->n; i++) {
+      for (size_t j = 0; j < b->n; j++) {
+        uint64_t b_value = rs1 == rs2 ? a->values[i] : b->values[j];
+        bool taken =
+            is_branch_taken(command, a->values[i], b_value, run->xlen);
+        int edge = taken ? 0 : 1;
+        set_add(&narrowed[edge][0], a->values[i], run->set_limit);
+        set_add(&narrowed[edge][1], b_value, run->set_limit);
+      }
+    }
+    for (int edge = 0; edge < 2; edge++) {
+      feasible[edge] = narrowed[edge][0].n > 0;
+      set_clear(&edges[edge][rs1]);
+      set_clear(&edges[edge][rs2]);
+      set_copy(&edges[edge][rs2], &narrowed[edge][1]);
+      if (rs1 != rs2) {
+        set_copy(&edges[edge][rs1], &narrowed[edge][0]);
+      }
+      set_clear(&narrowed[edge][0]);
+      set_clear(&narrowed[edge][1]);
+    }
+  }
+  if (feasible[0]) {
+    propagate(run, pc + imm_b, edges[0]);
+  }
+  if (feasible[1]) {
+    propagate(run, pc + 4, edges[1]);
+  }
+  regs_clear(edges[0]);
+  regs_clear(edges[1]);
+}
+
+static int access_bytes(command_index command) {
+  switch (command) {
+  case CMD_LB:
+  case CMD_LBU:
+  case CMD_SB:
+    return 1;
+  case CMD_LH:
+  case CMD_LHU:
+  case CMD_SH:
+    return 2;
+  case CMD_LW:
+  case CMD_LWU:
+  case CMD_SW:
+    return 4;
+  case CMD_LD:
+  case CMD_SD:
+    return 8;
+  default:
+    return 0;
+  }
+}
+
+static void step(footprint_run *run, size_t index) {
+  uint64_t pc = run->states[index].pc;
+  value_set regs[32];
+  regs_copy(regs, run->states[index].regs);
+  for (size_t i = 0; i < 32; i++) {
+    run->work += regs[i].n;
+  }
+  if (run->work > MAX_WORK) {
+    run->failed = true; // sets grow too slowly to reach their limit
+  }
+
+  uint32_t word = 0;
+  for (int i = 3; i >= 0; i--) {
+    if (find_symbolic_range(run->s, wrap_address(run, pc + i))) {
+      run->failed = true; // the command is chosen by the solver
+    }
+    add_cell(run, &run->fetched, pc + i);
+    word = word << 8;
+    word += get_memory_cell_content(run->s->memory,
+                                    wrap_address(run, pc + i));
+  }
+  command_index command = decode_command(word);
+  if (command == CMD_UNKNOWN ||
+      (run->xlen == 32 && is_rv64_only_command(command))) {
+    regs_clear(regs);
+    return; // bad, the run ends here
+  }
+  uint8_t rd = (word >> 7) & 0x1f;
+  value_set *a = &regs[(word >> 15) & 0x1f];
+  value_set *b = &regs[(word >> 20) & 0x1f];
+  uint8_t opcode = word & 0x7f;
+  value_set result = {0};
+
+  if (opcode == 0x63) {
+    step_branch(run, command, word, pc, regs);
+    regs_clear(regs);
+    return;
+  } else if (opcode == 0x03 || opcode == 0x23) { // load or store
+    int64_t offset = opcode == 0x03
+                         ? sign_extend(word >> 20, 12)
+                         : sign_extend(((word >> 25) << 5) |
+                                           ((word >> 7) & 0x1f),
+                                       12);
+    value_set none = {0};
+    if (run->control_only && opcode == 0x03) {
+      a = &none; // loaded cells are not collected
+    } else if (a->top) {
+      run->failed = true; // unknown address
+    }
+    value_set *accessed = &run->states[index].accessed;
+    size_t k = 0; // both are sorted, so only new addresses are collected
+    for (size_t i = 0; i < a->n && !run->failed; i++) {
+      while (k < accessed->n && accessed->values[k] < a->values[i]) {
+        k++;
+      }
+      if (k < accessed->n && accessed->values[k] == a->values[i]) {
+        continue;
+      }
+      for (int j = 0; j < access_bytes(command); j++) {
+        add_cell(run, opcode == 0x03 ? &run->loaded : &run->stored,
+                 a->values[i] + offset + j);
+      }
+    }
+    set_join(accessed, a, SIZE_MAX);
+    result.top = true; // loaded value, stores have no rd
+  } else if (command == CMD_JALR) {
+    int64_t offset = sign_extend(word >> 20, 12);
+    if (a->top) {
+      run->failed = true; // unknown jump target
+    }
+    set_add(&result, execute_command(command, word, pc, 0, 0, run->xlen),
+            run->set_limit);
+    value_set next[32];
+    regs_copy(next, regs);
+    if (rd) {
+      set_clear(&next[rd]);
+      set_copy(&next[rd], &result);
+    }
+    for (size_t i = 0; i < a->n && !run->failed; i++) {
+      propagate(run, (a->values[i] + offset) & ~(uint64_t)1, next);
+    }
+    regs_clear(next);
+    set_clear(&result);
+    regs_clear(regs);
+    return;
+  } else if (command == CMD_LUI || command == CMD_AUIPC ||
+             command == CMD_JAL) {
+    set_add(&result, execute_command(command, word, pc, 0, 0, run->xlen),
+            run->set_limit);
+  } else { // math, register commands also use rs2
+    bool uses_rs2 = opcode == 0x33 || opcode == 0x3b;
+    value_set zero = {false, 1, (uint64_t[]){0}};
+    if (!uses_rs2) {
+      b = &zero;
+    }
+    if (a->top || b->top || a->n * b->n > MAX_PAIRS * run->set_limit) {
+      result.top = true;
+    }
+    for (size_t i = 0; i < a->n && !result.top; i++) {
+      for (size_t j = 0; j < b->n && !result.top; j++) {
+        set_add(&result,
+                execute_command(command, word, pc, a->values[i],
+                                b->values[j], run->xlen),
+                run->set_limit);
+      }
+    }
+  }
+
+  if (rd) {
+    set_clear(&regs[rd]);
+    regs[rd] = result;
+  } else {
+    set_clear(&result);
+  }
+  if (command == CMD_JAL) {
+    int64_t imm_j = sign_extend(((word >> 31) & 1) << 20 |
+                                    ((word >> 12) & 0xff) << 12 |
+                                    ((word >> 20) & 1) << 11 |
+                                    ((word >> 21) & 0x3ff) << 1,
+                                21);
+    propagate(run, pc + imm_j, regs);
+  } else {
+    propagate(run, pc + 4, regs);
+  }
+  regs_clear(regs);
+}
+
+static void footprint_start(footprint_run *run, state *s,
+                            uint64_t address_limit, int xlen,
+                            size_t max_states) {
+  run->s = s;
+  run->address_limit = address_limit;
+  run->xlen = xlen;
+  run->mask = xlen == 32 ? 0xffffffff : UINT64_MAX;
+
+  value_set regs[32] = {{0}};
+  for (size_t i = 0; i < 32; i++) { // uninitialised registers are zero
+    if (is_register_symbolic(s, i)) {
+      uint64_t min = s->regs_min[i] & run->mask;
+      uint64_t max = s->regs_max[i] & run->mask;
+      regs[i].top = max - min >= run->set_limit;
+      for (uint64_t value = min; !regs[i].top && value <= max; value++) {
+        set_add(&regs[i], value, run->set_limit);
+      }
+      continue;
+    }
+    set_add(&regs[i], is_register_initialised(s, i) ? s->regs_values[i] : 0,
+            run->set_limit);
+  }
+  propagate(run, s->pc, regs);
+  regs_clear(regs);
+
+  while (run->n_work && !run->failed) {
+    run->n_work--;
+    size_t index = run->worklist[run->n_work];
+    run->states[index].queued = false;
+    step(run, index);
+    if (run->n_states > max_states) {
+      run->failed = true;
+    }
+  }
+}
+
+static void footprint_end(footprint_run *run) {
+  for (size_t i = 0; i < run->n_states; i++) {
+    regs_clear(run->states[i].regs);
+    set_clear(&run->states[i].accessed);
+  }
+  free(run->states);
+  free(run->worklist);
+  set_clear(&run->cells);
+  set_clear(&run->fetched);
+  set_clear(&run->loaded);
+  set_clear(&run->stored);
+}
+
+size_t find_memory_footprint(state *s, uint64_t address_limit, int xlen,
+                             uint64_t *cells, uint8_t *kinds,
+                             size_t max_cells) {
+  footprint_run run = {0};
+  run.max_cells = max_cells;
+  run.set_limit = max_cells; // more values could not all be addresses
+  footprint_start(&run, s, address_limit, xlen, SIZE_MAX);
+
+  size_t n_cells = 0;
+  if (!run.failed) {
+    n_cells = run.cells.n;
+    for (size_t i = 0; i < n_cells; i++) {
+      cells[i] = run.cells.values[i];
+      kinds[i] = (set_contains(&run.fetched, cells[i]) ? FOOTPRINT_FETCH : 0) |
+                 (set_contains(&run.loaded, cells[i]) ? FOOTPRINT_LOAD : 0) |
+                 (set_contains(&run.stored, cells[i]) ? FOOTPRINT_STORE : 0);
+    }
+  }
+  footprint_end(&run);
+  return n_cells;
+}
+
+size_t find_reachable_pcs(state *s, uint64_t address_limit, int xlen,
+                          uint64_t *pcs, size_t max_pcs) {
+  footprint_run run = {0};
+  run.control_only = true;
+  run.max_cells = SIZE_MAX; // the work budget bounds the stores
+  run.set_limit = CONTROL_SET_LIMIT;
+  footprint_start(&run, s, address_limit, xlen, max_pcs);
+
+  for (size_t i = 0; i < run.stored.n && !run.failed; i++) {
+    if (set_contains(&run.fetched, run.stored.values[i])) {
+      run.failed = true; // the code can change
+    }
+  }
+  size_t n_pcs = 0;
+  if (!run.failed) {
+    n_pcs = run.n_states;
+    for (size_t i = 0; i < n_pcs; i++) {
+      pcs[i] = run.states[i].pc;
+    }
+    qsort(pcs, n_pcs, sizeof(uint64_t), compare_alt);
+  }
+  footprint_end(&run);
+  return n_pcs;
+}
+
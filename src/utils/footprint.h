@@ -0,0 +1,34 @@
+#include "./state.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef FOOTPRINT
+#define FOOTPRINT
+
+// How a cell of the footprint is accessed
+#define FOOTPRINT_FETCH 1
+#define FOOTPRINT_LOAD 2
+#define FOOTPRINT_STORE 4
+
+// Collects every memory cell a run from the state can fetch, load or store
+// before it reaches a bad command. Registers are followed as sets of constants
+// and branches on constants narrow them, so counted loops stay bounded.
+// Writes the sorted cell addresses to cells, their accesses to kinds and
+// returns their number. Returns 0 if an address is not known or more than
+// max_cells cells are touched. An address_limit of 0 lets addresses wrap at the
+// register width instead. Commands are decoded from the initial memory, so
+// cells that are both fetched and stored make the result unreliable.
+size_t find_memory_footprint(state *s, uint64_t address_limit, int xlen,
+                             uint64_t *cells, uint8_t *kinds,
+                             size_t max_cells);
+
+// Collects every pc a run from the state can reach before a bad command, the
+// same way. Jalr targets must be known, loads may read anywhere. Stores must
+// be known and miss the fetched cells, so the code does not change. Writes
+// the sorted pcs and returns their number, 0 if the control flow is not
+// bounded or more than max_pcs pcs are found.
+size_t find_reachable_pcs(state *s, uint64_t address_limit, int xlen,
+                          uint64_t *pcs, size_t max_pcs);
+
+#endif // FOOTPRINT
@@ -0,0 +1,204 @@
+#include "./loops.h"
+#include "./decoder.h"
+#include "./memory_table.h"
+#include "./state.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+static int64_t sign_extend(uint64_t value, int bits) {
+  uint64_t sign = (uint64_t)1 << (bits - 1);
+  value &= (sign << 1) - 1;
+  return (int64_t)(value ^ sign) - (int64_t)sign;
+}
+
+static bool fetch(state *s, uint64_t address, uint64_t address_limit,
+                  uint32_t *word) {
+  // Only commands that are given by the state and can not be chosen by the
+  // solver are taken
+  if (address + 4 > address_limit || address + 4 < address) {
+    return false;
+  }
+  *word = 0;
+  for (int i = 3; i >= 0; i--) {
+    if (!exists_address_in_table(s->memory, address + i) ||
+        find_symbolic_range(s, address + i)) {
+      return false;
+    }
+    *word = *word << 8;
+    *word += get_memory_cell_content(s->memory, address + i);
+  }
+  return true;
+}
+
+static bool is_jump_to(uint32_t word, uint64_t pc, uint64_t target,
+                       int xlen) {
+  // A jump that does not link, with a target known without registers
+  uint64_t mask = xlen == 32 ? 0xffffffff : UINT64_MAX;
+  if (((word >> 7) & 0x1f) != 0) {
+    return false;
+  }
+  switch (decode_command(word)) {
+  case CMD_JAL:
+    return ((pc + sign_extend(((word >> 31) & 1) << 20 |
+                                  ((word >> 12) & 0xff) << 12 |
+                                  ((word >> 20) & 1) << 11 |
+                                  ((word >> 21) & 0x3ff) << 1,
+                              21)) &
+            mask) == target;
+  case CMD_JALR:
+    return ((word >> 15) & 0x1f) == 0 &&
+           ((sign_extend(word >> 20, 12) & ~(uint64_t)1) & mask) == target;
+  default:
+    return false;
+  }
+}
+
+static bool parse_body_command(uint32_t word, counting_loop *loop,
+                               int xlen) {
+  command_index command = decode_command(word);
+  uint8_t rd = (word >> 7) & 0x1f;
+  uint8_t rs1 = (word >> 15) & 0x1f;
+  uint8_t rs2 = (word >> 20) & 0x1f;
+  loop_update *update = &loop->body[loop->n_body];
+  update->command = command;
+  switch (command) {
+  case CMD_ADDI:
+    update->rd = rd;
+    update->rs = 0;
+    update->immediate = sign_extend(word >> 20, 12);
+    return rd != 0 && rs1 == rd;
+  case CMD_ADD: // commutative, the register added to can be either one
+    update->rd = rd;
+    update->rs = rs1 == rd ? rs2 : rs1;
+    update->immediate = 0;
+    return rd != 0 && (rs1 == rd) != (rs2 == rd);
+  case CMD_SD:
+    if (xlen == 32) {
+      return false;
+    }
+    // fall through
+  case CMD_SB:
+  case CMD_SH:
+  case CMD_SW:
+    update->rd = rs2;
+    update->rs = rs1;
+    update->immediate =
+        sign_extend(((word >> 25) << 5) | ((word >> 7) & 0x1f), 12);
+    return rs1 == loop->counter;
+  default:
+    return false;
+  }
+}
+
+static bool is_counting_loop(counting_loop *loop) {
+  // Registers written in the loop are only read by the command that writes
+  // them, except for the counter, which the adds and stores may read
+  bool written[32] = {false};
+  written[loop->counter] = true;
+  for (size_t i = 0; i < loop->n_body; i++) {
+    loop_update *update = &loop->body[i];
+    if (update->command == CMD_ADDI || update->command == CMD_ADD) {
+      if (update->rd == loop->counter) {
+        return false;
+      }
+      written[update->rd] = true;
+    }
+  }
+  if (written[loop->bound]) {
+    return false;
+  }
+  for (size_t i = 0; i < loop->n_body; i++) {
+    loop_update *update = &loop->body[i];
+    if (update->command == CMD_ADD && update->rs != loop->counter &&
+        written[update->rs]) {
+      return false;
+    }
+    if (update->command != CMD_ADDI && update->command != CMD_ADD &&
+        written[update->rd]) {
+      return false; // the stored value changes
+    }
+  }
+  return true;
+}
+
+static bool find_loop_at(state *s, uint64_t head, uint64_t address_limit,
+                         int xlen, counting_loop *loop) {
+  uint32_t word;
+  if (!fetch(s, head, address_limit, &word)) {
+    return false;
+  }
+  command_index branch = decode_command(word);
+  if (branch != CMD_BGE && branch != CMD_BGEU) {
+    return false;
+  }
+  loop->head = head;
+  loop->is_unsigned = branch == CMD_BGEU;
+  loop->counter = (word >> 15) & 0x1f;
+  loop->bound = (word >> 20) & 0x1f;
+  loop->n_body = 0;
+  if (loop->counter == 0 || loop->counter == loop->bound) {
+    return false;
+  }
+  uint64_t pc = head + 4;
+  while (fetch(s, pc, address_limit, &word)) {
+    uint32_t next_word;
+    if (decode_command(word) == CMD_ADDI &&
+        ((word >> 7) & 0x1f) == loop->counter &&
+        ((word >> 15) & 0x1f) == loop->counter &&
+        sign_extend(word >> 20, 12) > 0 &&
+        fetch(s, pc + 4, address_limit, &next_word) &&
+        is_jump_to(next_word, pc + 4, head, xlen)) {
+      loop->step = sign_extend(word >> 20, 12);
+      loop->end = pc + 8;
+      return is_counting_loop(loop);
+    }
+    if (loop->n_body == MAX_LOOP_BODY ||
+        !parse_body_command(word, loop, xlen)) {
+      return false;
+    }
+    loop->n_body++;
+    pc += 4;
+  }
+  return false;
+}
+
+size_t find_counting_loops(state *s, uint64_t address_limit, int xlen,
+                           counting_loop *loops, size_t max_loops) {
+  size_t found = 0;
+  uint64_t *addresses = get_initialised_adresses(s->memory);
+  uint64_t last_word = 0;
+  bool first = true;
+  for (size_t i = 1; i <= addresses[0] && found < max_loops; i++) {
+    uint64_t word = addresses[i] - ((addresses[i] - s->pc) % 4);
+    if ((!first && word == last_word) || word >= address_limit) {
+      continue;
+    }
+    first = false;
+    last_word = word;
+    if (find_loop_at(s, word, address_limit, xlen, &loops[found])) {
+      found++;
+    }
+  }
+  free(addresses);
+  return found;
+}
+
+size_t loop_commands(counting_loop *loop) {
+  return (loop->end - loop->head) / 4;
+}
+
+int loop_store_bytes(loop_update *update) {
+  switch (update->command) {
+  case CMD_SB:
+    return 1;
+  case CMD_SH:
+    return 2;
+  case CMD_SW:
+    return 4;
+  case CMD_SD:
+    return 8;
+  default:
+    return 0;
+  }
+}
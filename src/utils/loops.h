@@ -0,0 +1,53 @@
+#include "./decoder.h"
+#include "./state.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef LOOPS
+#define LOOPS
+
+#define MAX_LOOP_BODY 16 // commands between the exit branch and the increment
+
+// What one command of the body does in every iteration. ADDI adds immediate
+// to rd, ADD adds rs to rd and stores write rd to immediate(rs).
+typedef struct loop_update {
+  command_index command;
+  uint8_t rd;
+  uint8_t rs;
+  int64_t immediate;
+} loop_update;
+
+// A loop of the form
+//   head: bge[u] counter, bound, <exit>
+//         <body>
+//         addi counter, counter, step
+//         jal/jalr x0, <head>
+// whose body only adds constants, the counter or registers the loop does not
+// write to registers nothing else in it reads, and stores registers it does
+// not write at the counter plus an offset. After k iterations every register
+// is known in closed form, so they can be done in a single transition.
+typedef struct counting_loop {
+  uint64_t head;
+  uint64_t end; // exclusive, after the jump back
+  bool is_unsigned;
+  uint8_t counter;
+  uint8_t bound;
+  int64_t step; // positive
+  loop_update body[MAX_LOOP_BODY];
+  size_t n_body;
+} counting_loop;
+
+// Finds the counting loops in the concrete, initialised memory of the state
+// below address_limit, at words aligned to its pc. Writes at most max_loops
+// of them to loops and returns their number.
+size_t find_counting_loops(state *s, uint64_t address_limit, int xlen,
+                           counting_loop *loops, size_t max_loops);
+
+// Commands of one iteration, the branch and the jump back included
+size_t loop_commands(counting_loop *loop);
+
+// Bytes a command of the body stores, 0 for the adds
+int loop_store_bytes(loop_update *update);
+
+#endif // LOOPS
@@ -0,0 +1,4687 @@
+#include "./cone.h"
+#include "./decoder.h"
+#include "./execute.h"
+#include "./footprint.h"
+#include "./loops.h"
+#include "./model.h"
+#include "./model_cache.h"
+#include "./state.h"
+#include "./template.h"
+#include "./writer.h"
+#include <getopt.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BTOR_MEMORY_SIZE 16 // Should be raised to 16 or 32 in future
+#define AUTO_WIDTH_CELLS 4096 // footprint limit when -a auto bounds accesses
+#define MAX_REACHABLE_PCS 65536 // control flow limit for the pc constraint
+#define MAX_LOOPS 64 // counting loops that can be accelerated
+#define MAX_STORE_ACCELERATE 8 // bits of k if a loop stores, it is unrolled
+#define MAX_FAST_FORWARD ((uint64_t)1 << 32) // to a pc, without -n
+#define TEMPLATE_MIN_INSTANCES 16 // from here on the transition is reused
+
+static int memsize = BTOR_MEMORY_SIZE;
+static uint64_t pow_memsize = 1 << BTOR_MEMORY_SIZE; // 2^BTOR_MEMORY_SIZE
+static bool address_range_check = false; // -a auto, out of memory is bad
+static bool halt_check = false; // a program that can not go on is bad
+static bool halt_at_exit = false;
+static uint64_t exit_address = 0; // reaching it halts, if halt_at_exit
+
+enum long_only_options {
+  OPT_ISA_SUBSET = 256,
+  OPT_MEMORY_REGIONS,
+  OPT_WRITEBACK,
+  OPT_MEMORY_INIT,
+  OPT_MEMORY_CELLS,
+  OPT_STORE,
+  OPT_REGISTERS,
+  OPT_XLEN,
+  OPT_SCALAR_MEMORY,
+  OPT_PC_CONSTRAINT,
+  OPT_DEAD_CODE,
+  OPT_HALT,
+  OPT_PROPS,
+  OPT_HARTS,
+  OPT_ACCELERATE,
+  OPT_FAST_FORWARD,
+  OPT_FAST_FORWARD_TO,
+  OPT_FAST_FORWARD_STATE,
+  OPT_CACHE_DIR,
+  OPT_CACHE_SIZE
+};
+
+static bool isa_subset_auto = false; // only emit commands found in the program
+static bool used_commands[COMMAND_COUNT];
+
+static bool shared_writeback = true; // select rd value once, not per register
+static bool memory_regions = false;  // seperate read-only memory for the code
+static bool store_select = false; // a write chain per store width, by ite
+static uint64_t code_start = 0;
+static uint64_t code_end = 0; // exclusive
+
+static int big_step = 1; // commands executed per transition
+
+static bool register_array = false; // one array state instead of 32
+static int register_file_sort = 0;
+
+static int xlen = 0;           // register width, 0 takes the one of the state
+static int register_sort = 6;  // D, or W for RV32
+
+// Memory is an array of cells, these are single bytes unless word addressed
+static int cell_bytes = 1;
+static int cell_shift = 0; // log2(cell_bytes)
+static int index_sort = 2; // AS
+static int cell_sort = 3;  // B
+static int memory_sort = 7;
+static int span_sort = 0; // bitvec of the widest cell span of loads and stores
+
+// With a bounded footprint every cell the program touches is a state of its
+// own. Cells that stores change come first, a memory is the id of the first
+// of them and the other cells keep their initial state.
+static size_t max_scalar_cells = 0; // 0 always uses the memory array
+static size_t scalar_cells = 0;
+static size_t scalar_stored = 0;
+static uint64_t *scalar_addresses = NULL;
+static uint8_t *scalar_kinds = NULL; // FOOTPRINT_FETCH, _LOAD and _STORE bits
+static int scalar_states = 0;
+static int scalar_address_consts = 0; // empty cell comes right before
+
+// Sorted pcs the control flow can reach from the initial state. They bound the
+// pc state by a constraint and show the commands no run executes.
+static bool pc_constraint = false;
+static bool dead_code_report = false;
+static size_t *n_reachable_pcs = NULL; // per instance
+static uint64_t **reachable_pcs = NULL;
+
+// Several states with the same code give one model. Each instance has its own
+// registers, pc, memory and bads, whose names start with its prefix. The
+// constants, the counter and the code memory of memory regions are shared.
+static int n_instances = 1;
+static int instance = 0;            // the one being emitted
+static char instance_name[16] = ""; // its prefix, empty for a single state
+
+// With several harts each has its own pc, registers and flags, named with
+// "h<k>." after hart 0, on the shared memory. An input picks the hart that
+// executes the command of a transition.
+static int n_harts = 0; // 0 takes the register sections of the state
+static char register_name[32] = ""; // of the hart emitted, its prefix
+
+// A transition at the head of a counting loop can do k of its iterations at
+// once, k is an input. Registers, memory and counter are set as if each of
+// them was executed, which is only allowed if none of them exits the loop.
+static int accelerate_bits = 0; // width of k, 0 does not accelerate
+static counting_loop *loops = NULL;
+static size_t n_loops = 0;
+
+// The state can be executed concretely before the model is emitted, which
+// then starts where that run stopped. It stops before anything a bad could
+// see. The counter starts at the commands run, so -n keeps its meaning.
+static uint64_t fast_forward_steps = 0; // at most, 0 does not run
+static bool fast_forward_to_pc = false;
+static uint64_t fast_forward_target = 0; // pc the run stops at, if to pc
+static char *fast_forward_file = NULL;   // the state it stopped at goes there
+static uint64_t counter_start = 0;
+static int model_iterations = 1; // -n, commands until the counter is bad
+
+// Models of earlier runs, found by a hash of the options and states
+static char *cache_dir = NULL;
+static uint64_t cache_bytes = (uint64_t)MODEL_CACHE_SIZE << 20;
+static cache_key model_key;
+
+// Without harts, scalar memory and acceleration the transition of an instance
+// only depends on the lines of its state, not on their values. With many
+// instances it is recorded once and written again at the ids of each one.
+// They are kept for the next models of the process, so after enough of them
+// the first instance is written from one as well. The first instance has the
+// counter bad, so it has a template of its own.
+static model_template *transition_templates[2] = {NULL, NULL};
+static int shared_lines = 0; // constants and counter, before any instance
+static int transitions_written = 0; // by the process
+
+// How the initial memory is given to the model
+typedef enum memory_init_encoding {
+  INIT_CHAIN,      // one write per initialised byte on empty memory
+  INIT_DEFAULT,    // most frequent byte everywhere, writes for the rest
+  INIT_CONSTRAINT, // default byte everywhere, the rest constrained at step 0
+  INIT_AUTO        // choose per state
+} memory_init_encoding;
+static memory_init_encoding memory_init = INIT_CHAIN;
+
+// Bad properties in the order they are emitted, every step sets their check
+typedef enum bad_index {
+  BAD_COUNTER,
+  BAD_UNKNOWN_OPCODE,
+  BAD_COMMAND,
+  BAD_MISALIGNED,
+  BAD_STORE_TO_CODE,
+  BAD_OUT_OF_RANGE,
+  BAD_HALTED,
+  BAD_COUNT
+} bad_index;
+static const char *bad_names[BAD_COUNT] = {
+    "counter_maxed", "unknown_opcode", "error_in_command(guess_funct3)",
+    "misaligned_instruction_fetch_ERROR", "store_to_code",
+    "address_out_of_range", "program_halted"};
+static const char *prop_names[BAD_COUNT] = {"counter",       "opcode",
+                                     "command",       "misaligned",
+                                     "store_to_code", "out_of_range",
+                                     "halted"};
+// With --props only the chosen bads and what they need are emitted
+static bool selected_props[BAD_COUNT] = {true, true, true, true,
+                                        true, true, true};
+static bool slice_props = false;
+
+bool is_command_used(int command) {
+  if (xlen == 32 && is_rv64_only_command(command)) {
+    return false; // falls to unknown_opcode like any other unknown command
+  }
+  return !isa_subset_auto || used_commands[command];
+}
+
+int btor_or_list(writer *f, int next_line, int *locs, int n, int *result_loc) {
+  // Or over all n booleans in locs as balanced tree, false for an empty list
+  if (n == 0) {
+    *result_loc = 17;
+    return next_line;
+  }
+  int *level = malloc(n * sizeof(int));
+  memcpy(level, locs, n * sizeof(int));
+  while (n > 1) {
+    for (int i = 0; i < n / 2; i++) {
+      bprintf(f, "%d or 1 %d %d\n", next_line, level[2 * i],
+              level[2 * i + 1]);
+      level[i] = next_line;
+      next_line++;
+    }
+    if (n % 2) { // odd one out moves up a level
+      level[n / 2] = level[n - 1];
+    }
+    n = (n + 1) / 2;
+  }
+  *result_loc = level[0];
+  free(level);
+  return next_line;
+}
+
+int btor_register_select(writer *f, int next_line, int *registers, int code,
+                         const char *name, int *result_loc) {
+  // Selects the register named by code with a mux tree over its 5 bits
+  int code_bits = next_line;
+  for (int bit = 0; bit < 5; bit++) {
+    bprintf(f, "%d slice 1 %d %d %d %s_bit%d\n", next_line, code, bit, bit,
+            name, bit);
+    next_line++;
+  }
+  int level[32];
+  for (int i = 0; i < 32; i++) {
+    level[i] = registers[i];
+  }
+  for (int bit = 0, n = 32; bit < 5; bit++, n /= 2) {
+    for (int i = 0; i < n / 2; i++) {
+      bprintf(f, "%d ite %d %d %d %d\n", next_line, register_sort,
+              code_bits + bit,
+              level[2 * i + 1], level[2 * i]);
+      level[i] = next_line;
+      next_line++;
+    }
+  }
+  *result_loc = level[0];
+  return next_line;
+}
+
+int btor_constants(writer *f) { // This sadly grew as-needed
+  bprintf(f, "; Basics\n");
+  bprintf(f, "1 sort bitvec 1 Bool\n"); // booleans
+  bprintf(f, "2 sort bitvec %d AS\n",
+          memsize);                  // memory representation
+  bprintf(f, "3 sort bitvec 8 B\n"); // memory cell
+  bprintf(f, "4 sort bitvec 16 H\n");
+  bprintf(f, "5 sort bitvec 32 W\n");   // command
+  bprintf(f, "6 sort bitvec 64 D\n");   // registers
+  bprintf(f, "7 sort array 2 3 Mem\n"); // Array with BTOR_MEMORY_SIZE
+                                        // elements of 8 bit memory cells
+  bprintf(f, "8 zero %d empty_reg\n", register_sort); // register zero
+  bprintf(f, "9 constd 5 31 register_bitmask\n"); // bitmask for register codes
+  bprintf(f, "10 constd 5 7 shift_rd\n");
+  bprintf(f, "11 constd 5 15 shift_rs1\n");
+  bprintf(f, "12 constd 5 20 shift_rs2\n");
+  bprintf(f, "13 constd 5 12 shift_funct3\n");
+  bprintf(f, "14 constd 5 25 shift_funct7\n");
+  bprintf(f, "15 one 5 bit_picker\n");
+  bprintf(f, "16 one 1 true\n");
+  bprintf(f, "17 zero 1 false\n");
+  bprintf(f, "18 sort bitvec 5 RegisterCode\n");
+  int next_line = 19;
+  if (cell_bytes > 1) {
+    // Word addressed memory, cell sort is W or D
+    cell_sort = cell_bytes == 4 ? 5 : 6;
+    index_sort = 19;
+    memory_sort = 20;
+    span_sort = 21;
+    bprintf(f, "19 sort bitvec %d CellIndex\n", memsize - cell_shift);
+    bprintf(f, "20 sort array 19 %d CellMem\n", cell_sort);
+    bprintf(f, "21 sort bitvec %d CellSpan\n",
+            cell_bytes == 4 ? 96 : 128); // up to three W or two D cells
+    next_line = 22;
+  }
+  if (register_array) {
+    bprintf(f, "%d sort array 18 %d RegisterFile\n", next_line,
+            register_sort);
+    register_file_sort = next_line;
+    next_line++;
+  }
+  return next_line; // Next line number
+}
+int btor_counter(writer *f, int next_line) {
+  bprintf(f, ";\n; Counter for executed commands\n");
+  if (counter_start) { // Initial value of the counter
+    bprintf(f, "%d constd 6 %lu\n", next_line, counter_start);
+  } else {
+    bprintf(f, "%d zero 6\n", next_line);
+  }
+  bprintf(f, "%d constd 6 %d\n", next_line + 1,
+          big_step); // Commands per transition
+  bprintf(f, "%d state 6 iterations_counter\n",
+          next_line + 2); // 64bit should suffice
+  bprintf(f, "%d init 6 %d %d\n", next_line + 3, next_line + 2, next_line);
+  bprintf(f, "%d add 6 %d %d\n", next_line + 4, next_line + 1, next_line + 2);
+  if (accelerate_bits) {
+    return next_line + 5; // next depends on the jumps over loops
+  }
+  bprintf(f, "%d next 6 %d %d /n", next_line + 5, next_line + 2, next_line + 4);
+  return next_line + 6; // Next line number
+}
+
+int btor_register_initialisation_flags(writer *f, int next_line, state *s) {
+  bprintf(f, ";\n; Define Register Initialisation flags\n");
+  int reg_flags_loc = next_line;
+  for (uint8_t i = 0; i < 32; i++) {
+    bprintf(f, "%d state 1 %sflag_x%d\n", next_line, register_name, i);
+    next_line++;
+  }
+  for (uint8_t i = 0; i < 32; i++) {
+    if (is_register_initialised(s, i)) {
+      bprintf(f, "%d init 1 %d 16\n", next_line,
+              reg_flags_loc + i); // 16 is true
+    } else {
+      bprintf(f, "%d init 1 %d 17\n", next_line,
+              reg_flags_loc + i); // 17 is false
+    }
+    next_line++;
+  }
+  return next_line;
+}
+
+bool is_register_constant(state *s, size_t i) {
+  // Initialised to a value other than zero, with a constant of its own
+  return is_register_initialised(s, i) && !is_register_symbolic(s, i) &&
+         get_register(s, i) != 0;
+}
+
+bool has_symbolic_registers(state *s) {
+  for (size_t i = 0; i < 32; i++) {
+    if (is_register_symbolic(s, i)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int btor_register_consts(writer *f, int next_line, state *s) {
+  bprintf(f, ";\n; Define Register Constants\n");
+  for (size_t i = 0; i < 32; i++) {
+    if (is_register_constant(s, i)) {
+      int64_t value = get_register(s, i);
+      if (xlen == 32) {
+        value = (int32_t)value; // constd takes the signed 32 bit value
+      }
+      bprintf(f, "%d constd %d %ld\n", next_line, register_sort, value);
+      next_line++;
+    }
+  }
+  bprintf(f, "%d constd 2 %ld\n", next_line, s->pc % pow_memsize);
+  return next_line + 1;
+}
+
+int btor_register_file(writer *f, int next_line, int reg_const_loc, state *s,
+                       int *register_locs) {
+  // All registers in one array, x0 is never written and stays zero
+  bprintf(f, ";\n; Define Register File\n");
+  bprintf(f, "%d state %d %sinitial_registers\n", next_line,
+          register_file_sort, register_name);
+  bprintf(f, "%d init %d %d 8\n", next_line + 1, register_file_sort,
+          next_line);
+  int initial_registers = next_line;
+  bprintf(f, "%d state %d %sregisters\n", next_line + 2, register_file_sort,
+          register_name);
+  bprintf(f, "%d state 2 %spc\n", next_line + 3, register_name);
+  register_locs[0] = next_line + 2;
+  register_locs[32] = next_line + 3;
+  next_line += 4;
+
+  int not_null_regs = 0;
+  for (size_t i = 0; i < 32; i++) {
+    if (is_register_constant(s, i)) {
+      if (i) {
+        bprintf(f, "%d constd 18 %ld\n", next_line, i);
+        bprintf(f, "%d write %d %d %d %d\n", next_line + 1,
+                register_file_sort, initial_registers, next_line,
+                reg_const_loc + not_null_regs);
+        initial_registers = next_line + 1;
+        next_line += 2;
+      }
+      not_null_regs++;
+    }
+  }
+  if (has_symbolic_registers(s)) { // fixed by constraints in the first step
+    bprintf(f, "%d init 2 %d %d\n", next_line, register_locs[32],
+            reg_const_loc + not_null_regs);
+    return next_line + 1;
+  }
+  bprintf(f, "%d init %d %d %d\n", next_line, register_file_sort,
+          register_locs[0], initial_registers);
+  bprintf(f, "%d init 2 %d %d\n", next_line + 1, register_locs[32],
+          reg_const_loc + not_null_regs);
+  return next_line + 2;
+}
+
+int btor_registers(writer *f, int next_line, int reg_const_loc, state *s,
+                   int *register_locs) {
+  if (register_array) {
+    return btor_register_file(f, next_line, reg_const_loc, s, register_locs);
+  }
+  bprintf(f, ";\n; Define Registers\n");
+  int reg_state_loc = next_line;
+  for (size_t i = 0; i < 33; i++) { // PC is assumed as 32th register
+    register_locs[i] = reg_state_loc + i;
+  }
+  for (size_t i = 0; i < 32; i++) {
+    bprintf(f, "%d state %d %sx%ld\n", next_line, register_sort,
+            register_name, i);
+    next_line++;
+  }
+  bprintf(f, "%d state 2 %spc\n", next_line, register_name);
+  next_line++;
+
+  int not_null_regs = 0;
+  for (size_t i = 0; i < 32; i++) {
+    if (is_register_constant(s, i)) {
+      bprintf(f, "%d init %d %ld %d\n", next_line, register_sort,
+              reg_state_loc + i, reg_const_loc + not_null_regs);
+      not_null_regs++;
+    } else if (is_register_symbolic(s, i)) {
+      continue; // chosen by the solver
+    } else {
+      bprintf(f, "%d init %d %ld 8\n", next_line, register_sort,
+              reg_state_loc + i);
+    }
+    next_line++;
+  }
+  bprintf(f, "%d init 2 %d %d\n", next_line, reg_state_loc + 32,
+          reg_const_loc + not_null_regs);
+  return next_line + 1;
+}
+
+int btor_in_range(writer *f, int next_line, int sort, int value, uint64_t min,
+                  uint64_t max, int first_step) {
+  // Constrains value to [min, max] in the first step
+  bprintf(f, "%d consth %d %lx\n", next_line, sort, min);
+  bprintf(f, "%d consth %d %lx\n", next_line + 1, sort, max);
+  bprintf(f, "%d ugte 1 %d %d\n", next_line + 2, value, next_line);
+  bprintf(f, "%d ulte 1 %d %d\n", next_line + 3, value, next_line + 1);
+  bprintf(f, "%d and 1 %d %d\n", next_line + 4, next_line + 2,
+          next_line + 3);
+  bprintf(f, "%d implies 1 %d %d\n", next_line + 5, first_step,
+          next_line + 4);
+  bprintf(f, "%d constraint %d\n", next_line + 6, next_line + 5);
+  return next_line + 7;
+}
+
+int btor_symbolic_registers(writer *f, int next_line, int reg_const_loc,
+                            int counter_loc, state *s, int *register_locs) {
+  // Symbolic registers are free states, bounded in the first step. In a
+  // register file the other registers are fixed there as well.
+  if (!has_symbolic_registers(s)) {
+    return next_line;
+  }
+  bprintf(f, ";\n; Symbolic registers\n");
+  bprintf(f, "%d eq 1 %d %d first_step\n", next_line, counter_loc,
+          counter_loc - 2); // counter is at its start
+  int first_step = next_line;
+  next_line++;
+  uint64_t mask = xlen == 32 ? 0xffffffff : UINT64_MAX;
+  int not_null_regs = 0;
+  for (size_t i = 0; i < 32; i++) {
+    int value = register_locs[i];
+    if (register_array) {
+      bprintf(f, "%d constd 18 %ld\n", next_line, i);
+      bprintf(f, "%d read %d %d %d\n", next_line + 1, register_sort,
+              register_locs[0], next_line);
+      value = next_line + 1;
+      next_line += 2;
+    }
+    if (is_register_symbolic(s, i)) {
+      uint64_t min = s->regs_min[i] & mask;
+      uint64_t max = s->regs_max[i] & mask;
+      if (min || max != mask) {
+        next_line = btor_in_range(f, next_line, register_sort, value, min,
+                                  max, first_step);
+      }
+      continue;
+    }
+    if (!register_array) {
+      continue; // concrete registers have their init
+    }
+    int content = 8; // empty_reg
+    if (is_register_constant(s, i)) {
+      content = reg_const_loc + not_null_regs;
+      not_null_regs++;
+    }
+    bprintf(f, "%d eq 1 %d %d\n", next_line, value, content);
+    bprintf(f, "%d implies 1 %d %d\n", next_line + 1, first_step,
+            next_line);
+    bprintf(f, "%d constraint %d\n", next_line + 2, next_line + 1);
+    next_line += 3;
+  }
+  return next_line;
+}
+
+uint64_t *get_initialised_cells(state *s) {
+  // [0] is the number of cells, followed by their indices
+  uint64_t *addresses = get_initialised_adresses(s->memory);
+  uint64_t *cells = malloc((addresses[0] + 1) * sizeof(uint64_t));
+  cells[0] = 0;
+  for (size_t i = 1; i <= addresses[0] && addresses[i] < pow_memsize; i++) {
+    uint64_t index = addresses[i] >> cell_shift;
+    if (!cells[0] || cells[cells[0]] != index) {
+      cells[0]++;
+      cells[cells[0]] = index;
+    }
+  }
+  free(addresses);
+  return cells;
+}
+
+uint64_t get_cell(state *s, uint64_t index) {
+  uint64_t content = 0; // little endian, uninitialised bytes are zero
+  for (int i = cell_bytes - 1; i >= 0; i--) {
+    content = content << 8;
+    content += get_memory_cell_content(s->memory, (index << cell_shift) + i);
+  }
+  return content;
+}
+
+uint64_t symbolic_cell_mask(state *s, uint64_t index) {
+  // Bits of the cell that belong to symbolic bytes
+  uint64_t mask = 0;
+  for (int i = 0; i < cell_bytes; i++) {
+    if (find_symbolic_range(s, (index << cell_shift) + i)) {
+      mask |= (uint64_t)0xff << (8 * i);
+    }
+  }
+  return mask;
+}
+
+bool is_cell_bounded(state *s, uint64_t index) {
+  // A symbolic byte of the cell does not take every value
+  for (int i = 0; i < cell_bytes; i++) {
+    symbolic_range *range = find_symbolic_range(s, (index << cell_shift) + i);
+    if (range && (range->min != 0 || range->max != 0xff)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int btor_symbolic_ranges(writer *f, int next_line, state *s, uint64_t index,
+                         int cell, int first_step) {
+  // Bounds the symbolic bytes of a cell in the first step
+  for (int i = 0; i < cell_bytes; i++) {
+    symbolic_range *range = find_symbolic_range(s, (index << cell_shift) + i);
+    if (!range || (range->min == 0 && range->max == 0xff)) {
+      continue;
+    }
+    int byte = cell;
+    if (cell_bytes > 1) {
+      bprintf(f, "%d slice 3 %d %d %d\n", next_line, cell, 8 * i + 7, 8 * i);
+      byte = next_line;
+      next_line++;
+    }
+    next_line = btor_in_range(f, next_line, 3, byte, range->min, range->max,
+                              first_step);
+  }
+  return next_line;
+}
+
+int btor_symbolic_cell(writer *f, int next_line, state *s, uint64_t index,
+                       int cell, uint64_t content, int first_step) {
+  // Fixes the concrete bytes of a cell in the first step and bounds the
+  // symbolic ones
+  uint64_t mask = symbolic_cell_mask(s, index);
+  uint64_t cell_mask = cell_bytes == 8 ? UINT64_MAX
+                                       : ((uint64_t)1 << (8 * cell_bytes)) - 1;
+  if (mask != cell_mask) {
+    bprintf(f, "%d consth %d %lx\n", next_line, cell_sort, ~mask & cell_mask);
+    bprintf(f, "%d and %d %d %d\n", next_line + 1, cell_sort, cell,
+            next_line);
+    bprintf(f, "%d consth %d %lx\n", next_line + 2, cell_sort,
+            content & ~mask);
+    bprintf(f, "%d eq 1 %d %d\n", next_line + 3, next_line + 1,
+            next_line + 2);
+    bprintf(f, "%d implies 1 %d %d\n", next_line + 4, first_step,
+            next_line + 3);
+    bprintf(f, "%d constraint %d\n", next_line + 5, next_line + 4);
+    next_line += 6;
+  }
+  return btor_symbolic_ranges(f, next_line, s, index, cell, first_step);
+}
+
+int compare_cells(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a;
+  uint64_t y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+uint64_t *get_symbolic_cells(state *s) {
+  // [0] is the number of cells with a symbolic byte, followed by their indices
+  size_t n_bytes = 0;
+  for (size_t i = 0; i < s->n_symbolic_memory; i++) {
+    symbolic_range *range = &s->symbolic_memory[i];
+    if (range->start < pow_memsize && range->start <= range->end) {
+      uint64_t end = range->end < pow_memsize ? range->end : pow_memsize - 1;
+      n_bytes += end - range->start + 1;
+    }
+  }
+  uint64_t *cells = malloc((n_bytes + 1) * sizeof(uint64_t));
+  size_t n_cells = 0;
+  for (size_t i = 0; i < s->n_symbolic_memory; i++) {
+    symbolic_range *range = &s->symbolic_memory[i];
+    for (uint64_t address = range->start;
+         address <= range->end && address < pow_memsize; address++) {
+      uint64_t index = address >> cell_shift;
+      if (!n_cells || cells[n_cells] != index) {
+        n_cells++;
+        cells[n_cells] = index;
+      }
+    }
+  }
+  qsort(cells + 1, n_cells, sizeof(uint64_t), compare_cells);
+  cells[0] = 0;
+  for (size_t i = 1; i <= n_cells; i++) { // ranges may overlap
+    if (!cells[0] || cells[cells[0]] != cells[i]) {
+      cells[0]++;
+      cells[cells[0]] = cells[i];
+    }
+  }
+  return cells;
+}
+
+memory_init_encoding choose_memory_init(state *s, uint64_t *cells,
+                                        uint64_t *default_cell) {
+  // Counts the writes every encoding needs, uninitialised memory is zero
+  uint64_t cell_count = pow_memsize >> cell_shift;
+  uint64_t *values = malloc((cells[0] + 1) * sizeof(uint64_t));
+  for (size_t i = 1; i <= cells[0]; i++) {
+    values[i - 1] = get_cell(s, cells[i]);
+  }
+  qsort(values, cells[0], sizeof(uint64_t), compare_cells);
+  uint64_t zero_count = 0;
+  uint64_t most_frequent = 0;
+  uint64_t most_frequent_count = 0;
+  for (size_t i = 0; i < cells[0];) {
+    size_t run = i;
+    while (run < cells[0] && values[run] == values[i]) {
+      run++;
+    }
+    if (!values[i]) {
+      zero_count = run - i;
+    } else if (run - i > most_frequent_count) {
+      most_frequent = values[i];
+      most_frequent_count = run - i;
+    }
+    i = run;
+  }
+  free(values);
+
+  *default_cell = 0;
+  uint64_t default_writes = cells[0] - zero_count;
+  if (cell_count - most_frequent_count < default_writes) {
+    *default_cell = most_frequent;
+    default_writes = cell_count - most_frequent_count;
+  }
+  if (memory_init != INIT_AUTO) {
+    if (memory_init == INIT_CHAIN) {
+      *default_cell = 0;
+    }
+    return memory_init;
+  }
+  // Chain writes every cell, plus one if the first is zero. Constraints fix
+  // the same cells as default writes, with more lines for each.
+  if (default_writes < cells[0]) {
+    return INIT_DEFAULT;
+  }
+  *default_cell = 0;
+  return INIT_CHAIN;
+}
+
+int btor_memory(writer *f, int next_line, state *s, int counter_loc,
+                int *memory_loc,
+                int *code_memory_loc) { // Fills the memory with initialised
+                                        // values. Only takes the first
+                                        // pow(2, BTOR_MEMORY_SIZE) addresses
+                                        // into account.
+  uint64_t *cells = get_initialised_cells(s);
+  uint64_t *symbolic_cells = get_symbolic_cells(s);
+  uint64_t default_cell;
+  memory_init_encoding encoding = choose_memory_init(s, cells, &default_cell);
+  bool code_memory = memory_regions && !*code_memory_loc;
+  bprintf(f, ";\n; Define memory\n");
+  bprintf(f, "%d zero %d empty_cell\n", next_line, cell_sort);
+  int empty_cell = next_line;
+  next_line++;
+  int default_loc = empty_cell;
+  if (default_cell) {
+    bprintf(f, "%d consth %d %lx default_cell\n", next_line, cell_sort,
+            default_cell);
+    default_loc = next_line;
+    next_line++;
+  }
+  // Constraints alone start from the default cell, writes need an array
+  int memory_initializer = default_loc;
+  int empty_memory = 0;
+  if (encoding != INIT_CONSTRAINT || symbolic_cells[0] || code_memory) {
+    bprintf(f, "%d state %d %smemory_initialzer\n", next_line, memory_sort,
+            instance_name);
+    bprintf(f, "%d init %d %d %d\n", next_line + 1, memory_sort, next_line,
+            default_loc); // Initialise the memory with empty cells
+    memory_initializer = next_line;
+    empty_memory = next_line;
+    next_line += 2;
+  }
+
+  if (encoding == INIT_DEFAULT) {
+    // Only cells that differ from the default are written, this includes
+    // uninitialised ones if the default is not zero
+    bprintf(f, "; Default cell is %lx\n", default_cell);
+    size_t i = 1;
+    for (uint64_t index = 0; index < pow_memsize >> cell_shift; index++) {
+      if (i <= cells[0] && cells[i] == index) {
+        i++;
+      } else if (!default_cell) {
+        // Only initialised cells can differ from an empty default
+        if (i > cells[0]) {
+          break;
+        }
+        index = cells[i] - 1;
+        continue;
+      }
+      uint64_t content = get_cell(s, index);
+      if (content == default_cell) {
+        continue;
+      }
+      bprintf(f, "%d consth %d %lx\n", next_line, cell_sort, content);
+      bprintf(f, "%d constd %d %ld\n", next_line + 1, index_sort, index);
+      bprintf(f, "%d write %d %d %d %d\n", next_line + 2, memory_sort,
+              memory_initializer, next_line + 1, next_line);
+      memory_initializer = next_line + 2;
+      next_line += 3;
+    }
+  }
+
+  for (size_t i = 1; encoding == INIT_CHAIN && i <= cells[0];
+       i++) { // TODO also initialise 0s??
+    // get_initialised_cells only takes the first pow(2, BTOR_MEMORY_SIZE)
+    // addresses into account
+    uint64_t content = get_cell(s, cells[i]);
+    if (content == 0) {
+      bprintf(f, "%d constd %d %ld\n", next_line, index_sort,
+              cells[i]); // size of cells[i] is always smaller than
+                         // 2^BTOR_MEMORY_SIZE
+      int mem_adr = next_line;
+      next_line++;
+      // If first byte is 0, this does not change zero initialised memory and
+      // btormc does not track. therefore, I created a change that will be
+      // overwritten, so 0-bytes will always be tracked.
+      if (i == 1) {
+        bprintf(f, "%d one %d\n", next_line, cell_sort);
+        bprintf(f, "%d write %d %d %d %d\n", next_line + 1, memory_sort,
+                memory_initializer, mem_adr, next_line);
+        memory_initializer = next_line + 1;
+        next_line += 2;
+      }
+      bprintf(f, "%d write %d %d %d %d\n", next_line, memory_sort,
+              memory_initializer, mem_adr, empty_cell);
+      memory_initializer = next_line;
+      next_line++;
+    } else {
+      bprintf(f, "%d consth %d %lx\n", next_line, cell_sort, content);
+      bprintf(f, "%d constd %d %ld\n", next_line + 1, index_sort, cells[i]);
+      bprintf(f, "%d write %d %d %d %d\n", next_line + 2, memory_sort,
+              memory_initializer, next_line + 1, next_line);
+      memory_initializer = next_line + 2;
+      next_line += 3;
+    }
+  }
+
+  int *symbolic_indices = malloc((symbolic_cells[0] + 1) * sizeof(int));
+  if (symbolic_cells[0]) {
+    // Symbolic bytes come from a memory without init, concrete ones stay
+    bprintf(f, "%d state %d %smemory_symbolic\n", next_line, memory_sort,
+            instance_name);
+    int symbolic_memory = next_line;
+    next_line++;
+    uint64_t cell_mask = cell_bytes == 8
+                             ? UINT64_MAX
+                             : ((uint64_t)1 << (8 * cell_bytes)) - 1;
+    for (size_t i = 1; i <= symbolic_cells[0]; i++) {
+      uint64_t index = symbolic_cells[i];
+      bprintf(f, "%d constd %d %ld\n", next_line, index_sort, index);
+      bprintf(f, "%d read %d %d %d\n", next_line + 1, cell_sort,
+              symbolic_memory, next_line);
+      symbolic_indices[i] = next_line;
+      int value = next_line + 1;
+      next_line += 2;
+      uint64_t mask = symbolic_cell_mask(s, index);
+      uint64_t content = get_cell(s, index) & ~mask;
+      if (mask != cell_mask) {
+        bprintf(f, "%d consth %d %lx\n", next_line, cell_sort, mask);
+        bprintf(f, "%d and %d %d %d\n", next_line + 1, cell_sort, value,
+                next_line);
+        value = next_line + 1;
+        next_line += 2;
+      }
+      if (content) {
+        bprintf(f, "%d consth %d %lx\n", next_line, cell_sort, content);
+        bprintf(f, "%d or %d %d %d\n", next_line + 1, cell_sort, value,
+                next_line);
+        value = next_line + 1;
+        next_line += 2;
+      }
+      bprintf(f, "%d write %d %d %d %d\n", next_line, memory_sort,
+              memory_initializer, symbolic_indices[i], value);
+      memory_initializer = next_line;
+      next_line++;
+    }
+  }
+
+  if (code_memory) {
+    // Only holds the code, so reads from it skip the long initialisation.
+    // Instances share the one of the first, their code is the same.
+    bprintf(f, ";\n; Define read-only code memory\n");
+    int code_initializer = empty_memory;
+    for (uint64_t index = code_start >> cell_shift;
+         index <= (code_end - 1) >> cell_shift; index++) {
+      uint64_t content = get_cell(s, index);
+      if (content == default_cell) {
+        continue; // already set
+      }
+      bprintf(f, "%d consth %d %lx\n", next_line, cell_sort, content);
+      bprintf(f, "%d constd %d %ld\n", next_line + 1, index_sort, index);
+      bprintf(f, "%d write %d %d %d %d\n", next_line + 2, memory_sort,
+              code_initializer, next_line + 1, next_line);
+      code_initializer = next_line + 2;
+      next_line += 3;
+    }
+    bprintf(f, "%d state %d memory_code\n", next_line, memory_sort);
+    bprintf(f, "%d init %d %d %d\n", next_line + 1, memory_sort, next_line,
+            code_initializer);
+    bprintf(f, "%d next %d %d %d memory_code_constant\n", next_line + 2,
+            memory_sort, next_line, next_line);
+    *code_memory_loc = next_line;
+    next_line += 3;
+  }
+
+  bprintf(f, "%d state %d %smemory\n", next_line, memory_sort, instance_name);
+  bprintf(f, "%d init %d %d %d\n", next_line + 1, memory_sort, next_line,
+          memory_initializer);
+  *memory_loc = next_line;
+  next_line += 2;
+
+  bool bounded = false;
+  for (size_t i = 1; i <= symbolic_cells[0] && !bounded; i++) {
+    bounded = is_cell_bounded(s, symbolic_cells[i]);
+  }
+  if (encoding != INIT_CONSTRAINT && !bounded) {
+    free(symbolic_indices);
+    free(symbolic_cells);
+    free(cells);
+    return next_line;
+  }
+  bprintf(f, "%d eq 1 %d %d first_step\n", next_line, counter_loc,
+          counter_loc - 2); // counter is at its start
+  int first_step = next_line;
+  next_line++;
+
+  if (encoding == INIT_CONSTRAINT) {
+    // Only cells that differ from the default are fixed in the first step
+    bprintf(f, "; Constrain memory cells in the first step, default cell "
+               "is %lx\n",
+            default_cell);
+  }
+  uint64_t last_content = 0;
+  int content_loc = empty_cell;
+  size_t i = 1;
+  for (uint64_t index = 0;
+       encoding == INIT_CONSTRAINT && index < pow_memsize >> cell_shift;
+       index++) {
+    if (i <= cells[0] && cells[i] == index) {
+      i++;
+    } else if (!default_cell) {
+      if (i > cells[0]) {
+        break;
+      }
+      index = cells[i] - 1;
+      continue;
+    }
+    uint64_t content = get_cell(s, index);
+    if (content == default_cell ||
+        (symbolic_cells[0] && symbolic_cell_mask(s, index))) {
+      continue; // symbolic cells are written
+    }
+    if (content != last_content) { // runs of equal cells share the constant
+      if (content) {
+        bprintf(f, "%d consth %d %lx\n", next_line, cell_sort, content);
+        content_loc = next_line;
+        next_line++;
+      } else {
+        content_loc = empty_cell;
+      }
+      last_content = content;
+    }
+    bprintf(f, "%d constd %d %ld\n", next_line, index_sort, index);
+    bprintf(f, "%d read %d %d %d\n", next_line + 1, cell_sort, *memory_loc,
+            next_line);
+    bprintf(f, "%d eq 1 %d %d\n", next_line + 2, next_line + 1, content_loc);
+    bprintf(f, "%d implies 1 %d %d\n", next_line + 3, first_step,
+            next_line + 2);
+    bprintf(f, "%d constraint %d\n", next_line + 4, next_line + 3);
+    next_line += 5;
+  }
+
+  for (size_t i = 1; i <= symbolic_cells[0]; i++) {
+    if (!is_cell_bounded(s, symbolic_cells[i])) {
+      continue;
+    }
+    bprintf(f, "%d read %d %d %d\n", next_line, cell_sort, *memory_loc,
+            symbolic_indices[i]);
+    next_line = btor_symbolic_ranges(f, next_line + 1, s, symbolic_cells[i],
+                                     next_line, first_step);
+  }
+  free(symbolic_indices);
+  free(symbolic_cells);
+  free(cells);
+  return next_line;
+}
+
+int btor_scalar_memory(writer *f, int next_line, state *s, int counter_loc,
+                       int *memory_loc) {
+  // One state per footprint cell, initialised with its byte of the state
+  bprintf(f, ";\n; Define memory cells of the footprint\n");
+  bprintf(f, "%d zero 3 empty_cell\n", next_line);
+  next_line++;
+  scalar_address_consts = next_line;
+  for (size_t i = 0; i < scalar_cells; i++) {
+    bprintf(f, "%d constd 2 %ld\n", next_line, scalar_addresses[i]);
+    next_line++;
+  }
+  int contents[scalar_cells];
+  for (size_t i = 0; i < scalar_cells; i++) {
+    uint8_t content = get_memory_cell_content(s->memory, scalar_addresses[i]);
+    contents[i] = scalar_address_consts - 1;
+    if (content) {
+      bprintf(f, "%d consth 3 %x\n", next_line, content);
+      contents[i] = next_line;
+      next_line++;
+    }
+  }
+  scalar_states = next_line;
+  for (size_t i = 0; i < scalar_cells; i++) {
+    bprintf(f, "%d state 3 %smemory_%lx\n", next_line, instance_name,
+            scalar_addresses[i]);
+    next_line++;
+  }
+  int first_step = 0;
+  for (size_t i = 0; i < scalar_cells; i++) {
+    if (!find_symbolic_range(s, scalar_addresses[i])) {
+      bprintf(f, "%d init 3 %d %d\n", next_line, scalar_states + (int)i,
+              contents[i]);
+      next_line++;
+      continue;
+    }
+    if (!first_step) {
+      bprintf(f, "%d eq 1 %d %d first_step\n", next_line, counter_loc,
+              counter_loc - 2); // counter is at its start
+      first_step = next_line;
+      next_line++;
+    }
+    next_line = btor_symbolic_cell(f, next_line, s, scalar_addresses[i],
+                                   scalar_states + (int)i, 0, first_step);
+  }
+  *memory_loc = scalar_states;
+  return next_line;
+}
+
+typedef struct cell_reads {
+  // The cells from the one at an address on, read once for all accesses there
+  int memory;
+  int address; // of the address sort
+  int n_indices;
+  int n_cells; // read so far
+  int indices[3];
+  int values[3];
+} cell_reads;
+
+int cell_span_sort(int cells) {
+  // Sort of cells concatenated cells
+  switch (cells * cell_bytes) {
+  case 4:
+    return 5;
+  case 8:
+    return 6;
+  default:
+    return span_sort;
+  }
+}
+
+int aligned_cells(int bytes) {
+  // Cells an access touches if it crosses no more cell borders than it has to
+  return bytes > cell_bytes ? bytes / cell_bytes : 1;
+}
+
+int spanned_cells(int bytes) {
+  // Cells a misaligned access can touch
+  return (2 * cell_bytes - 2 + bytes) / cell_bytes;
+}
+
+int btor_cell_indices(writer *f, int next_line, cell_reads *c, int cells) {
+  // Indices of the first cells, the ones known before are kept
+  for (; c->n_indices < cells; c->n_indices++) {
+    int i = c->n_indices;
+    if (i == 0) {
+      bprintf(f, "%d slice %d %d %d %d cell_index\n", next_line, index_sort,
+              c->address, memsize - 1, cell_shift);
+      c->indices[0] = next_line;
+      next_line++;
+      continue;
+    }
+    bprintf(f, "%d constd %d %d\n", next_line, index_sort, i);
+    bprintf(f, "%d add %d %d %d\n", next_line + 1, index_sort, c->indices[0],
+            next_line);
+    c->indices[i] = next_line + 1;
+    next_line += 2;
+  }
+  return next_line;
+}
+
+int btor_read_cells(writer *f, int next_line, cell_reads *c, int cells) {
+  // Reads the first cells, the ones read before are kept
+  next_line = btor_cell_indices(f, next_line, c, cells);
+  for (; c->n_cells < cells; c->n_cells++) {
+    bprintf(f, "%d read %d %d %d\n", next_line, cell_sort, c->memory,
+            c->indices[c->n_cells]);
+    c->values[c->n_cells] = next_line;
+    next_line++;
+  }
+  return next_line;
+}
+
+int btor_concat_cells(writer *f, int next_line, cell_reads *c, int cells,
+                      int *span) {
+  // The first cells little endian, the first one lowest
+  *span = c->values[0];
+  for (int i = 1; i < cells; i++) {
+    bprintf(f, "%d concat %d %d %d\n", next_line, cell_span_sort(i + 1),
+            c->values[i], *span);
+    *span = next_line;
+    next_line++;
+  }
+  return next_line;
+}
+
+int btor_offset_bits(writer *f, int next_line, int address, int cells,
+                     int *offset_bits) {
+  // The shift that moves the byte at address to the front of its cell, in
+  // the sort of cells concatenated cells
+  int sort = cell_span_sort(cells);
+  int width = cells * cell_bytes * 8;
+  if (width >= memsize) {
+    bprintf(f, "%d uext %d %d %d\n", next_line, sort, address,
+            width - memsize);
+  } else {
+    bprintf(f, "%d slice %d %d %d 0\n", next_line, sort, address, width - 1);
+  }
+  bprintf(f, "%d constd %d %d\n", next_line + 1, sort, cell_bytes - 1);
+  bprintf(f, "%d and %d %d %d\n", next_line + 2, sort, next_line,
+          next_line + 1); // byte offset inside the first cell
+  bprintf(f, "%d constd %d 3\n", next_line + 3, sort);
+  bprintf(f, "%d sll %d %d %d cell_offset_bits\n", next_line + 4, sort,
+          next_line + 2, next_line + 3);
+  *offset_bits = next_line + 4;
+  return next_line + 5;
+}
+
+int bytes_sort(int bytes) {
+  // B, H, W or D
+  switch (bytes) {
+  case 1:
+    return 3;
+  case 2:
+    return 4;
+  case 4:
+    return 5;
+  default:
+    return 6;
+  }
+}
+
+int btor_read_span(writer *f, int next_line, cell_reads *c, int bytes,
+                   int cells, int *value) {
+  // Reads bytes from the first cells, shifted by the offset in the first
+  // one unless they are aligned cells read whole
+  next_line = btor_read_cells(f, next_line, c, cells);
+  next_line = btor_concat_cells(f, next_line, c, cells, value);
+  if (bytes == cells * cell_bytes) {
+    return next_line;
+  }
+  int offset_bits;
+  next_line = btor_offset_bits(f, next_line, c->address, cells, &offset_bits);
+  bprintf(f, "%d srl %d %d %d\n", next_line, cell_span_sort(cells), *value,
+          offset_bits);
+  bprintf(f, "%d slice %d %d %d 0\n", next_line + 1, bytes_sort(bytes),
+          next_line, bytes * 8 - 1);
+  *value = next_line + 1;
+  return next_line + 2;
+}
+
+int btor_word_read(writer *f, int next_line, cell_reads *c, int bytes,
+                   int *value) {
+  // Reads bytes little endian from word addressed memory. An access inside
+  // of its aligned cells reads only those, only a misaligned one reads all
+  // cells it can touch.
+  int cells = aligned_cells(bytes);
+  next_line = btor_read_span(f, next_line, c, bytes, cells, value);
+  int spanned = spanned_cells(bytes);
+  if (spanned == cells) {
+    return next_line; // bytes never cross a cell border
+  }
+  int misaligned;
+  next_line = btor_read_span(f, next_line, c, bytes, spanned, &misaligned);
+  int last_offset = bytes < cell_bytes ? cell_bytes - bytes : 0;
+  bprintf(f, "%d constd 2 %d\n", next_line, cell_bytes - 1);
+  bprintf(f, "%d and 2 %d %d\n", next_line + 1, c->address, next_line);
+  bprintf(f, "%d constd 2 %d\n", next_line + 2, last_offset);
+  bprintf(f, "%d ulte 1 %d %d aligned_access\n", next_line + 3,
+          next_line + 1, next_line + 2);
+  bprintf(f, "%d ite %d %d %d %d\n", next_line + 4, bytes_sort(bytes),
+          next_line + 3, *value, misaligned);
+  *value = next_line + 4;
+  return next_line + 5;
+}
+
+int btor_write_span(writer *f, int next_line, cell_reads *c, int bytes,
+                    int cells, int value, int mask, int *new_memory,
+                    int *store_mask) {
+  // Writes the lowest bytes of value into the first cells, from the offset
+  // in the first one on unless they are aligned cells written whole. If mask
+  // is given, only its bytes of value are written. The mask as it is
+  // shifted onto the cells is returned in store_mask, 0 if there is none.
+  int sort = cell_span_sort(cells);
+  int new_span = next_line;
+  *store_mask = 0;
+  if (!mask && bytes == cells * cell_bytes) {
+    // Cells written whole need no read of what they held before
+    bprintf(f, "%d slice %d %d %d 0\n", next_line, sort, value,
+            bytes * 8 - 1);
+    next_line++;
+  } else {
+    int span;
+    next_line = btor_read_cells(f, next_line, c, cells);
+    next_line = btor_concat_cells(f, next_line, c, cells, &span);
+    int offset_bits;
+    next_line =
+        btor_offset_bits(f, next_line, c->address, cells, &offset_bits);
+    int extension = cells * cell_bytes * 8 - bytes * 8;
+    bprintf(f, "%d slice %d %d %d 0\n", next_line, bytes_sort(bytes), value,
+            bytes * 8 - 1);
+    int stored = next_line;
+    next_line++;
+    if (mask) {
+      bprintf(f, "%d slice %d %d %d 0\n", next_line, bytes_sort(bytes), mask,
+              bytes * 8 - 1);
+    } else {
+      bprintf(f, "%d ones %d\n", next_line, bytes_sort(bytes));
+    }
+    *store_mask = next_line;
+    next_line++;
+    if (extension) {
+      bprintf(f, "%d uext %d %d %d\n", next_line, sort, stored, extension);
+      bprintf(f, "%d uext %d %d %d\n", next_line + 1, sort, *store_mask,
+              extension);
+      stored = next_line;
+      *store_mask = next_line + 1;
+      next_line += 2;
+    }
+    bprintf(f, "%d sll %d %d %d\n", next_line, sort, stored,
+            offset_bits); // masked bytes are cleared below
+    bprintf(f, "%d sll %d %d %d store_mask\n", next_line + 1, sort,
+            *store_mask, offset_bits);
+    bprintf(f, "%d and %d %d -%d\n", next_line + 2, sort, span,
+            next_line + 1); // keep the bytes around the store
+    bprintf(f, "%d and %d %d %d\n", next_line + 3, sort, next_line,
+            next_line + 1); // only the masked bytes of value
+    bprintf(f, "%d or %d %d %d\n", next_line + 4, sort, next_line + 2,
+            next_line + 3);
+    *store_mask = next_line + 1;
+    new_span = next_line + 4;
+    next_line += 5;
+  }
+
+  next_line = btor_cell_indices(f, next_line, c, cells);
+  *new_memory = c->memory;
+  for (int i = 0; i < cells; i++) {
+    int index = c->indices[i];
+    if (cells == 1) {
+      bprintf(f, "%d write %d %d %d %d\n", next_line, memory_sort,
+              *new_memory, index, new_span);
+      *new_memory = next_line;
+      next_line++;
+      continue;
+    }
+    bprintf(f, "%d slice %d %d %d %d\n", next_line, cell_sort, new_span,
+            (i + 1) * cell_bytes * 8 - 1, i * cell_bytes * 8);
+    bprintf(f, "%d write %d %d %d %d\n", next_line + 1, memory_sort,
+            *new_memory, index, next_line);
+    *new_memory = next_line + 1;
+    next_line += 2;
+  }
+  return next_line;
+}
+
+int btor_word_write(writer *f, int next_line, cell_reads *c, int bytes,
+                    int value, int mask, int *new_memory) {
+  // Writes the lowest bytes of value little endian into word addressed
+  // memory, if mask is given only its bytes. A store inside of its aligned
+  // cells writes only those, only a misaligned one all cells it can touch.
+  int cells = aligned_cells(bytes);
+  int aligned, aligned_mask;
+  next_line = btor_write_span(f, next_line, c, bytes, cells, value, mask,
+                              &aligned, &aligned_mask);
+  int spanned = spanned_cells(bytes);
+  if (spanned == cells) {
+    *new_memory = aligned;
+    return next_line;
+  }
+  int misaligned, spanned_mask;
+  next_line = btor_write_span(f, next_line, c, bytes, spanned, value, mask,
+                              &misaligned, &spanned_mask);
+  // Aligned if no stored byte is shifted past the aligned cells
+  bprintf(f, "%d slice %d %d %d %d\n", next_line,
+          cell_span_sort(spanned - cells), spanned_mask,
+          spanned * cell_bytes * 8 - 1, cells * cell_bytes * 8);
+  bprintf(f, "%d redor 1 %d\n", next_line + 1, next_line);
+  bprintf(f, "%d ite %d -%d %d %d aligned_store\n", next_line + 2,
+          memory_sort, next_line + 1, aligned, misaligned);
+  *new_memory = next_line + 2;
+  return next_line + 3;
+}
+
+int scalar_cell(int memory, size_t i) {
+  // Cells that are never stored to stay the initial states
+  return i < scalar_stored ? memory + (int)i : scalar_states + (int)i;
+}
+
+int btor_read_byte(writer *f, int next_line, int memory, int address, int kind,
+                   int *value) {
+  if (!scalar_cells) {
+    bprintf(f, "%d read 3 %d %d\n", next_line, memory, address);
+    *value = next_line;
+    return next_line + 1;
+  }
+  // Only cells accessed this way can be at address, so the last of them is
+  // taken without comparing
+  *value = scalar_address_consts - 1;
+  bool first = true;
+  for (size_t i = scalar_cells; i-- > 0;) {
+    if (!(scalar_kinds[i] & kind)) {
+      continue;
+    }
+    if (first) {
+      *value = scalar_cell(memory, i);
+      first = false;
+      continue;
+    }
+    bprintf(f, "%d eq 1 %d %d\n", next_line, address,
+            scalar_address_consts + (int)i);
+    bprintf(f, "%d ite 3 %d %d %d\n", next_line + 1, next_line,
+            scalar_cell(memory, i), *value);
+    *value = next_line + 1;
+    next_line += 2;
+  }
+  return next_line;
+}
+
+int btor_write_byte(writer *f, int next_line, int memory, int previous_memory,
+                    int address, int value, int enable, const char *name,
+                    int *new_memory) {
+  // Writes value if enabled, otherwise the byte of memory is written back
+  if (!scalar_cells) {
+    bprintf(f, "%d read 3 %d %d\n", next_line, memory, address);
+    bprintf(f, "%d ite 3 %d %d %d\n", next_line + 1, enable, value,
+            next_line);
+    bprintf(f, "%d write 7 %d %d %d%s\n", next_line + 2, previous_memory,
+            address, next_line + 1, name);
+    *new_memory = next_line + 2;
+    return next_line + 3;
+  }
+  int hits = next_line;
+  for (size_t i = 0; i < scalar_stored; i++) {
+    bprintf(f, "%d eq 1 %d %d\n", next_line, address,
+            scalar_address_consts + (int)i);
+    bprintf(f, "%d and 1 %d %d\n", next_line + 1, next_line, enable);
+    next_line += 2;
+  }
+  *new_memory = scalar_stored ? next_line : previous_memory;
+  for (size_t i = 0; i < scalar_stored; i++) {
+    bprintf(f, "%d ite 3 %d %d %d%s\n", next_line, hits + 2 * (int)i + 1,
+            value, previous_memory + (int)i, i ? "" : name);
+    next_line++;
+  }
+  return next_line;
+}
+
+int btor_pc_in_code(writer *f, int next_line, int pc, int *pc_in_code) {
+  // Commands are only fetched from the code memory
+  bprintf(f, ";\n; Is the pc inside of the code memory\n");
+  bprintf(f, "%d constd 2 %ld code_start\n", next_line, code_start);
+  bprintf(f, "%d constd 2 %ld code_last_command\n", next_line + 1,
+          code_end - 4);
+  bprintf(f, "%d ugte 1 %d %d\n", next_line + 2, pc, next_line);
+  bprintf(f, "%d ulte 1 %d %d\n", next_line + 3, pc, next_line + 1);
+  bprintf(f, "%d and 1 %d %d pc_in_code\n", next_line + 4, next_line + 2,
+          next_line + 3);
+  *pc_in_code = next_line + 4;
+  return next_line + 5;
+}
+
+int btor_cell_command(writer *f, int next_line, int pc, int cell,
+                      int *command) {
+  // The half of a D cell the aligned pc points to
+  bprintf(f, "%d slice 1 %d 2 2\n", next_line, pc);
+  bprintf(f, "%d slice 5 %d 31 0\n", next_line + 1, cell);
+  bprintf(f, "%d slice 5 %d 63 32\n", next_line + 2, cell);
+  bprintf(f, "%d ite 5 %d %d %d\n", next_line + 3, next_line,
+          next_line + 2, next_line + 1);
+  *command = next_line + 3;
+  return next_line + 4;
+}
+
+int btor_get_current_command(writer *f, int next_line, int pc, int memory) {
+  bprintf(f, ";\n; Get the current command\n");
+  if (cell_bytes > 1 && selected_props[BAD_MISALIGNED]) {
+    // A misaligned pc is bad, so a single cell holds the whole command
+    cell_reads c = {.memory = memory, .address = pc};
+    next_line = btor_read_cells(f, next_line, &c, 1);
+    if (cell_bytes == 8) {
+      int command;
+      next_line = btor_cell_command(f, next_line, pc, c.values[0], &command);
+    }
+    return next_line; // the command is the last line
+  }
+  if (cell_bytes > 1) { // without the bad, a misaligned pc reads two cells
+    int command;
+    cell_reads c = {.memory = memory, .address = pc};
+    return btor_word_read(f, next_line, &c, 4, &command);
+  }
+  bprintf(f, "%d one 2\n", next_line);
+  int one = next_line;
+  next_line++;
+  int command_cells[4];
+  int cell_addresses[4] = {pc};
+  for (int i = 0; i < 4; i++) { // Read the memory at the PC address and after
+    if (i > 0) {
+      bprintf(f, "%d add 2 %d %d\n", next_line, cell_addresses[i - 1], one);
+      cell_addresses[i] = next_line;
+      next_line++;
+    }
+    next_line = btor_read_byte(f, next_line, memory, cell_addresses[i],
+                               FOOTPRINT_FETCH, &command_cells[i]);
+  }
+
+  bprintf(f, "%d concat 4 %d %d\n", next_line, command_cells[1],
+          command_cells[0]); // Concatenate the first two memory cells
+  bprintf(f, "%d concat 4 %d %d\n", next_line + 1, command_cells[3],
+          command_cells[2]); // Concatenate the last two memory cells
+  bprintf(f, "%d concat 5 %d %d\n", next_line + 2, next_line + 1,
+          next_line); // Concatenate all
+  return next_line + 3;
+}
+int btor_get_opcode(writer *f, int next_line, int command_loc) {
+  bprintf(f, ";\n; Get the opcode\n");
+  bprintf(f, "%d consth 5 07f\n", next_line); // bitmask
+  bprintf(f, "%d and 5 %d %d\n", next_line + 1, next_line,
+          command_loc); // Extract the opcode (first byte)
+  return next_line + 2;
+}
+int btor_get_destination(writer *f, int next_line, int command_loc) {
+  bprintf(f, ";\n; Get rd\n");
+  bprintf(f, "%d srl 5 %d 10\n", next_line,
+          command_loc); // shift so rd is in front
+  bprintf(f, "%d and 5 9 %d\n", next_line + 1, next_line); // use bitmask
+  return next_line + 2;
+}
+int btor_get_source1(writer *f, int next_line, int command_loc) {
+  bprintf(f, ";\n; Get rs1\n");
+  bprintf(f, "%d srl 5 %d 11\n", next_line,
+          command_loc); // shift so rs1 is in front
+  bprintf(f, "%d and 5 9 %d\n", next_line + 1, next_line); // use bitmask
+  return next_line + 2;
+}
+int btor_get_source2(writer *f, int next_line, int command_loc) {
+  bprintf(f, ";\n; Get rs2\n");
+  bprintf(f, "%d srl 5 %d 12\n", next_line,
+          command_loc); // shift so rs2 is in front
+  bprintf(f, "%d and 5 9 %d\n", next_line + 1, next_line); // use bitmask
+  return next_line + 2;
+}
+int btor_get_funct3(writer *f, int next_line, int command_loc) {
+  bprintf(f, ";\n; Get funct3\n");
+  bprintf(f, "%d srl 5 %d 13\n", next_line,
+          command_loc); // shift so rd is in front
+  bprintf(f, "%d and 5 %d 10\n", next_line + 1,
+          next_line); // use shift for rd as bitmask
+  return next_line + 2;
+}
+int btor_get_funct7(writer *f, int next_line, int command_loc) {
+  bprintf(f, ";\n; Get funct7\n");
+  bprintf(f, "%d srl 5 %d 14\n", next_line,
+          command_loc); // shift so funct7 is in front. No mask needed as there
+                        // is nothing left of funct7
+  return next_line + 1;
+}
+int btor_get_immediate(writer *f, int next_line, int command_loc, int *codes) {
+  bprintf(f, ";\n; Get immediate\n");
+  bprintf(f, ";\n; Set valid opcodes as constants\n");
+  bprintf(f, "%d constd 5 3 load\n", next_line);
+  bprintf(f, "%d constd 5 19 math_i\n", next_line + 1);
+  bprintf(f, "%d constd 5 23 auipc\n", next_line + 2);
+  bprintf(f, "%d constd 5 27 math_wi\n", next_line + 3);
+  bprintf(f, "%d constd 5 35 store\n", next_line + 4);
+  bprintf(f, "%d constd 5 51 math_reg\n", next_line + 5);
+  bprintf(f, "%d constd 5 55 lui\n", next_line + 6);
+  bprintf(f, "%d constd 5 59 math_w\n", next_line + 7);
+  bprintf(f, "%d constd 5 99 branch\n", next_line + 8);
+  bprintf(f, "%d constd 5 103 jump_r\n", next_line + 9);
+  bprintf(f, "%d constd 5 111 jump\n", next_line + 10);
+
+  int opcode_const_loc = next_line;
+  next_line += 11;
+
+  bprintf(f, ";\n; Get possible immediate values\n");
+  bprintf(f, "%d sra 5 %d 12 i-immediate\n", next_line,
+          command_loc); // shift right by 20
+  int i_immediate_loc = next_line;
+  next_line++;
+  ;
+
+  bprintf(f, "%d sra 5 %d 12\n", next_line, command_loc);
+  bprintf(f, "%d and 5 %d -9\n", next_line + 1,
+          next_line); // mask to remove lower 5 bit to get i[11:5] of s-type
+  bprintf(f, "%d add 5 %d %d s-immediate\n", next_line + 2, next_line + 1,
+          codes[1]); // add rd code as rd is i[4:0]
+  int s_immediate_loc = next_line + 2;
+  next_line += 3;
+
+  bprintf(f, "%d and 5 %d -15 [4:0]\n", next_line,
+          codes[1]); // mask rd to get i[4:1] of b-type
+  bprintf(f, "%d consth 5 3f\n", next_line + 1);
+  bprintf(f, "%d and 5 %d %d\n", next_line + 2, next_line + 1,
+          codes[5]); // mask funct7 to lower 6bit get i[10:5] of b-type
+  bprintf(f, "%d constd 5 5\n", next_line + 3);
+  bprintf(f, "%d sll 5 %d %d [10:5]\n", next_line + 4, next_line + 2,
+          next_line + 3); // move to correct place
+  bprintf(f, "%d add 5 %d %d [10:0]\n", next_line + 5, next_line + 4,
+          next_line); // combine
+  bprintf(f, "%d sll 5 15 10\n", next_line + 6);
+  bprintf(f, "%d and 5 %d %d\n", next_line + 7, next_line + 6, command_loc);
+  bprintf(f, "%d constd 5 4\n", next_line + 8);
+  bprintf(f, "%d sll 5 %d %d [11]\n", next_line + 9, next_line + 7,
+          next_line + 8);
+  bprintf(f, "%d add 5 %d %d [11:0]\n", next_line + 10, next_line + 5,
+          next_line + 9); // combine
+  bprintf(f, "%d sra 5 %d %d\n", next_line + 11, command_loc,
+          opcode_const_loc + 1); // shift right by 19 -> opcode math i
+  bprintf(f, "%d consth 5 fff\n", next_line + 12);
+  bprintf(f, "%d and 5 %d -%d [31:12]\n", next_line + 13, next_line + 11,
+          next_line + 12); // mask to get i[31:12] of u-type
+  bprintf(f, "%d add 5 %d %d b-immediate\n", next_line + 14, next_line + 13,
+          next_line + 10);
+  int b_immediate_loc = next_line + 14;
+  next_line += 15;
+
+  bprintf(f, "%d and 5 %d -%d u-immediate\n", next_line, command_loc,
+          b_immediate_loc - 2); // HACKY! reuse mask from b-type to get u[31:12]
+  int u_immediate_loc = next_line;
+  next_line++;
+
+  bprintf(f, "%d and 5 %d -15 [4:0]\n", next_line, codes[3]);
+  bprintf(f, "%d add 5 %d %d [10:0]\n", next_line + 1, next_line,
+          b_immediate_loc - 10); // HACKY AF!!! Point on i[10:5] of b-type
+  bprintf(f, "%d and 5 %d 15\n", next_line + 2, codes[3]);
+  bprintf(f, "%d constd 5 11\n", next_line + 3);
+  bprintf(f, "%d sll 5 %d %d [11]\n", next_line + 4, next_line + 2,
+          next_line + 3);
+  bprintf(f, "%d add 5 %d %d [11:0]\n", next_line + 5, next_line + 1,
+          next_line + 4); // combine
+  bprintf(f, "%d sll 5 %d 13 [14:12]\n", next_line + 6,
+          codes[4]); // [14:12] is at funct3
+  bprintf(f, "%d add 5 %d %d [14:0]\n", next_line + 7, next_line + 5,
+          next_line + 6); // combine
+  bprintf(f, "%d sll 5 %d 11 [19:15]\n", next_line + 8,
+          codes[2]); // [19:15] is at rs1
+  bprintf(f, "%d add 5 %d %d [19:0]\n", next_line + 9, next_line + 7,
+          next_line + 8); // combine
+  bprintf(f, "%d consth 5 fffff\n", next_line + 10);
+  bprintf(f, "%d sra 5 %d %d\n", next_line + 11, command_loc,
+          next_line + 10); // shift is way too much, but because arithmetic
+                           // right shift now all bits ar equal to highest bit
+  bprintf(f, "%d and 5 %d -%d [31:20]\n", next_line + 12, next_line + 11,
+          next_line + 10);
+  bprintf(f, "%d add 5 %d %d j-immediate\n", next_line + 13, next_line + 9,
+          next_line + 12);
+  int j_immediate_loc = next_line + 13;
+  next_line += 14;
+
+  bprintf(f, ";\n; sort opcodes to immediates\n");
+  bprintf(f, "%d eq 1 %d %d\n", next_line, opcode_const_loc,
+          codes[0]); // i opcode load
+  bprintf(f, "%d eq 1 %d %d\n", next_line + 1, opcode_const_loc + 1,
+          codes[0]); // i opcode math i
+  bprintf(f, "%d eq 1 %d %d\n", next_line + 2, opcode_const_loc + 2,
+          codes[0]); // u opcode auipc
+  bprintf(f, "%d eq 1 %d %d\n", next_line + 3, opcode_const_loc + 3,
+          codes[0]); // i opcode math wi
+  bprintf(f, "%d eq 1 %d %d\n", next_line + 4, opcode_const_loc + 4,
+          codes[0]); // s opcode store
+  bprintf(f, "%d eq 1 %d %d\n", next_line + 5, opcode_const_loc + 5,
+          codes[0]); //- opcode math reg
+  bprintf(f, "%d eq 1 %d %d\n", next_line + 6, opcode_const_loc + 6,
+          codes[0]); // u opcode lui
+  bprintf(f, "%d eq 1 %d %d\n", next_line + 7, opcode_const_loc + 7,
+          codes[0]); //- opcode math w
+  bprintf(f, "%d eq 1 %d %d\n", next_line + 8, opcode_const_loc + 8,
+          codes[0]); // b opcode branch
+  bprintf(f, "%d eq 1 %d %d\n", next_line + 9, opcode_const_loc + 9,
+          codes[0]); // i opcode jump r
+  bprintf(f, "%d eq 1 %d %d\n", next_line + 10, opcode_const_loc + 10,
+          codes[0]); // j opcode jump
+
+  // i types: JALR(jump r), LOAD, math i, math wi
+  bprintf(f, "%d or 1 %d %d\n", next_line + 11, next_line, next_line + 1);
+  bprintf(f, "%d or 1 %d %d\n", next_line + 12, next_line + 11, next_line + 3);
+  bprintf(f, "%d or 1 %d %d\n", next_line + 13, next_line + 12, next_line + 9);
+  // u types: AUIPC, LUI
+  bprintf(f, "%d or 1 %d %d\n", next_line + 14, next_line + 2, next_line + 6);
+
+  int i_type_loc = next_line + 13;
+  int s_type_loc = next_line + 4;
+  int b_type_loc = next_line + 8;
+  int u_type_loc = next_line + 14;
+  int j_type_loc = next_line + 10;
+  next_line += 15;
+
+  // i type as default, can be used for shift amount shamt in S[L|R][L|A]I
+  // commands
+  bprintf(f, "%d ite 5 %d %d 15 i/r\n", next_line, i_type_loc,
+          i_immediate_loc); // default to one to find errors. in random testing
+                            // an i val of 1 is unexpected. in r-type, i is not
+                            // used so it should have no impact
+  bprintf(f, "%d ite 5 %d %d %d s\n", next_line + 1, s_type_loc,
+          s_immediate_loc, next_line);
+  bprintf(f, "%d ite 5 %d %d %d b\n", next_line + 2, b_type_loc,
+          b_immediate_loc, next_line + 1);
+  bprintf(f, "%d ite 5 %d %d %d u\n", next_line + 3, u_type_loc,
+          u_immediate_loc, next_line + 2);
+  bprintf(f, "%d ite 5 %d %d %d j\n", next_line + 4, j_type_loc,
+          j_immediate_loc, next_line + 3);
+  return next_line + 5;
+}
+
+int btor_check_4_all_commands(writer *f, int next_line, int opcode_comp,
+                              int *codes, int *command_locs) {
+  int constants_funct3 = next_line;
+  bprintf(f, ";\n; constants for funct3\n");
+  for (size_t i = 0; i < 8; i++) {
+    bprintf(f, "%d constd 5 %ld\n", next_line, i);
+    next_line++;
+  }
+  int constant_funct7 = next_line;
+  bprintf(f, ";\n; Constant for funct7\n");
+  bprintf(f, "%d constd 5 32\n", next_line); // second highest bit of funct7 set
+  next_line++;
+
+  int comp_funct3 = next_line;
+  bprintf(f, ";\n; Compare current funct3\n");
+  for (size_t i = 0; i < 8; i++) {
+    bprintf(f, "%d eq 1 %d %ld\n", next_line, codes[4], constants_funct3 + i);
+    next_line++;
+  }
+
+  bprintf(f, ";\n; Compare current funct7\n");
+  bprintf(f, "%d and 5 %d %d\n", next_line, codes[5],
+          constant_funct7); // and bitwise
+  bprintf(f, "%d eq 1 %d %d funct7bit_set\n", next_line + 1, constant_funct7,
+          next_line); // still the same -> funct7 bit set
+  next_line += 2;
+  int comp_funct7 = next_line - 1;
+
+  int pre_comp = next_line;
+  bprintf(f, ";\n; Some commands check against funct7, funct3 & opcode. They "
+             "are pre-checked so we get an orderly list in the next step\n");
+  bprintf(f, "%d and 1 -%d %d SRL(I)(W)_pre\n", next_line, comp_funct7,
+          comp_funct3 + 5);
+  bprintf(f, "%d and 1 %d %d SRA(I)(W)_pre\n", next_line + 1, comp_funct7,
+          comp_funct3 + 5);
+  bprintf(f, "%d and 1 -%d %d ADD(W)_pre\n", next_line + 2, comp_funct7,
+          comp_funct3 + 0);
+  bprintf(f, "%d and 1 %d %d SUB(W)_pre\n", next_line + 3, comp_funct7,
+          comp_funct3 + 0);
+  next_line += 4;
+
+  bprintf(f, ";\n; Check all commands\n");
+  // {funct check, opcode check} for every command, in command_index order
+  int command_checks[COMMAND_COUNT][2] = {
+      // RV32I
+      {16, opcode_comp + 6},               // LUI
+      {16, opcode_comp + 2},               // AUIPC
+      {16, opcode_comp + 10},              // JAL
+      {comp_funct3 + 0, opcode_comp + 9},  // JALR
+      {comp_funct3 + 0, opcode_comp + 8},  // BEQ
+      {comp_funct3 + 1, opcode_comp + 8},  // BNE
+      {comp_funct3 + 4, opcode_comp + 8},  // BLT
+      {comp_funct3 + 5, opcode_comp + 8},  // BGE
+      {comp_funct3 + 6, opcode_comp + 8},  // BLTU
+      {comp_funct3 + 7, opcode_comp + 8},  // BGEU
+      {comp_funct3 + 0, opcode_comp + 0},  // LB
+      {comp_funct3 + 1, opcode_comp + 0},  // LH
+      {comp_funct3 + 2, opcode_comp + 0},  // LW
+      {comp_funct3 + 4, opcode_comp + 0},  // LBU; LD comes in RV64I
+      {comp_funct3 + 5, opcode_comp + 0},  // LHU; LWU comes in RV64I
+      {comp_funct3 + 0, opcode_comp + 4},  // SB
+      {comp_funct3 + 1, opcode_comp + 4},  // SH
+      {comp_funct3 + 2, opcode_comp + 4},  // SW; SD comes in RV64I
+      {comp_funct3 + 0, opcode_comp + 1},  // ADDI; SUBI doesnt exist
+      {comp_funct3 + 2, opcode_comp + 1},  // SLTI; SLLI is overwritten by RV64I
+      {comp_funct3 + 3, opcode_comp + 1},  // SLTIU
+      {comp_funct3 + 4, opcode_comp + 1},  // XORI; SRLI, SRAI are in RV64I
+      {comp_funct3 + 6, opcode_comp + 1},  // ORI
+      {comp_funct3 + 7, opcode_comp + 1},  // ANDI
+      {pre_comp + 2, opcode_comp + 5},     // ADD
+      {pre_comp + 3, opcode_comp + 5},     // SUB
+      {comp_funct3 + 1, opcode_comp + 5},  // SLL
+      {comp_funct3 + 2, opcode_comp + 5},  // SLT
+      {comp_funct3 + 3, opcode_comp + 5},  // SLTU
+      {comp_funct3 + 4, opcode_comp + 5},  // XOR
+      {pre_comp + 0, opcode_comp + 5},     // SRL
+      {pre_comp + 1, opcode_comp + 5},     // SRA
+      {comp_funct3 + 6, opcode_comp + 5},  // OR
+      {comp_funct3 + 7, opcode_comp + 5},  // AND
+      // RV64I
+      {comp_funct3 + 6, opcode_comp + 0},  // LWU
+      {comp_funct3 + 3, opcode_comp + 0},  // LD
+      {comp_funct3 + 3, opcode_comp + 4},  // SD
+      {comp_funct3 + 1, opcode_comp + 1},  // SLLI
+      {pre_comp + 0, opcode_comp + 1},     // SRLI
+      {pre_comp + 1, opcode_comp + 1},     // SRAI
+      {comp_funct3 + 0, opcode_comp + 3},  // ADDIW
+      {comp_funct3 + 1, opcode_comp + 3},  // SLLIW
+      {pre_comp + 0, opcode_comp + 3},     // SRLIW
+      {pre_comp + 1, opcode_comp + 3},     // SRAIW
+      {pre_comp + 2, opcode_comp + 7},     // ADDW
+      {pre_comp + 3, opcode_comp + 7},     // SUBW
+      {comp_funct3 + 1, opcode_comp + 7},  // SLLW
+      {pre_comp + 0, opcode_comp + 7},     // SRLW
+      {pre_comp + 1, opcode_comp + 7}};    // SRAW
+
+  for (size_t i = 0; i < COMMAND_COUNT; i++) {
+    if (!is_command_used(i)) {
+      command_locs[i] = 17; // never recognised, so it falls to unknown_opcode
+      continue;
+    }
+    bprintf(f, "%d and 1 %d %d\n", next_line, command_checks[i][0],
+            command_checks[i][1]);
+    command_locs[i] = next_line;
+    next_line++;
+  }
+  return next_line;
+}
+
+int btor_access_out_of_range(writer *f, int next_line, int address,
+                             int address_limit, int offsets,
+                             const int *commands, const int *bytes, int n,
+                             int *command_locs, int *result_loc) {
+  // Bad if a used command touches a byte beyond the memory. The first byte is
+  // checked as well, as the last one could wrap around
+  bprintf(f, "%d ugte 1 %d %d\n", next_line, address, address_limit);
+  int outside[8] = {next_line}; // by offset of the last byte
+  next_line++;
+  int checks[8];
+  int n_checks = 0;
+  for (int i = 0; i < n; i++) {
+    if (!is_command_used(commands[i])) {
+      continue;
+    }
+    int last = bytes[i] - 1;
+    if (!outside[last]) {
+      bprintf(f, "%d add %d %d %d\n", next_line, register_sort, address,
+              offsets + last);
+      bprintf(f, "%d ugte 1 %d %d\n", next_line + 1, next_line,
+              address_limit);
+      bprintf(f, "%d or 1 %d %d\n", next_line + 2, outside[0],
+              next_line + 1);
+      outside[last] = next_line + 2;
+      next_line += 3;
+    }
+    bprintf(f, "%d and 1 %d %d\n", next_line, command_locs[commands[i]],
+            outside[last]);
+    checks[n_checks] = next_line;
+    n_checks++;
+    next_line++;
+  }
+  return btor_or_list(f, next_line, checks, n_checks, result_loc);
+}
+
+int btor_updates(writer *f, int next_line, int *registers, int memory_loc,
+                 int *command_locs, int immediate_loc, int opcode_comp,
+                 int *codes, int *reg_flags, int *store_to_code_loc,
+                 int *out_of_range_loc, int *new_registers, int *new_flags,
+                 int *new_memory) {
+  bprintf(f, ";\n; Next Functions for Registers and Memory\n");
+  int comparison_constants_loc = next_line;
+  bprintf(f, "; Get rs1, rs2 values\n");
+  for (size_t i = 0; i < 33; i++) {
+    bprintf(f, "%d constd %d %ld\n", next_line, register_sort, i);
+    next_line++;
+  }
+  // Register codes are compared with 5 bit, not extended to 64 bit
+  bprintf(f, "%d slice 18 %d 4 0 rd_code\n", next_line, codes[1]);
+  int rd_code = next_line;
+  next_line++;
+  int register_code_consts = next_line - 1; // x0 is never compared
+  for (size_t i = 1; i < 32; i++) {
+    bprintf(f, "%d constd 18 %ld\n", next_line, i);
+    next_line++;
+  }
+
+  int rs1_val_loc;
+  int rs2_val_loc;
+  if (register_array) { // x0 is never written, so reading it gives zero
+    bprintf(f, "%d slice 18 %d 4 0\n", next_line, codes[2]);
+    bprintf(f, "%d read %d %d %d rs1_value\n", next_line + 1, register_sort,
+            registers[0], next_line);
+    bprintf(f, "%d slice 18 %d 4 0\n", next_line + 2, codes[3]);
+    bprintf(f, "%d read %d %d %d rs2_value\n", next_line + 3, register_sort,
+            registers[0], next_line + 2);
+    rs1_val_loc = next_line + 1;
+    rs2_val_loc = next_line + 3;
+    next_line += 4;
+  } else {
+    next_line = btor_register_select(f, next_line, registers, codes[2], "rs1",
+                                     &rs1_val_loc);
+    next_line = btor_register_select(f, next_line, registers, codes[3], "rs2",
+                                     &rs2_val_loc);
+  }
+
+  bprintf(f, ";\n; Calculating values for commands\n");
+  int address_limit = 0;
+  int range_checks[3]; // loads, stores and the next pc
+  int n_range_checks = 0;
+  if (address_range_check) {
+    bprintf(f, "%d consth %d %lx address_limit\n", next_line, register_sort,
+            pow_memsize);
+    address_limit = next_line;
+    next_line++;
+  }
+  bprintf(f, ";\n; Flow Control\n");
+  bprintf(f, "%d uext %d %d %d pc_val_64bit\n", next_line, register_sort,
+          registers[32], xlen - memsize);
+  int pc_64bit = next_line;
+  int immediate_64bit = immediate_loc; // already register wide for RV32
+  next_line++;
+  if (xlen == 64) {
+    bprintf(f, "%d sext 6 %d 32 immediate_64bit\n", next_line, immediate_loc);
+    immediate_64bit = next_line;
+    next_line++;
+  }
+  bprintf(f, "%d add %d %d %d auipc_rd\n", next_line, register_sort, pc_64bit,
+          immediate_64bit);
+  // as immediate is opcode sensitive, this holds for all commands
+  int pc_immediate_added = next_line;
+  int lui_rd = immediate_64bit; // is also sign extended immediate!
+  int auipc_rd = pc_immediate_added;
+  next_line++;
+
+  bprintf(f, "%d slice 2 %d %d 0 jal_pc\n", next_line, pc_immediate_added,
+          memsize - 1);
+  int jal_pc = next_line;
+  next_line++;
+
+  bprintf(f, "%d constd %d 4\n", next_line, register_sort);
+  bprintf(f, "%d add %d %d %d\n", next_line + 1, register_sort, pc_64bit,
+          next_line);
+  int jal_rd = next_line + 1; // pc + 4
+  next_line += 2;
+
+  bprintf(f, "%d add %d %d %d\n", next_line, register_sort, rs1_val_loc,
+          immediate_64bit);
+  bprintf(f, "%d and %d %d -%d\n", next_line + 1, register_sort, next_line,
+          comparison_constants_loc + 1);
+  int jalr_target = next_line + 1;
+  bprintf(f, "%d slice 2 %d %d 0\n", next_line + 2, next_line + 1, memsize - 1);
+  next_line += 3;
+  int jalr_pc = next_line - 1;
+  int jalr_rd = jal_rd; // JALR rd is the same as JAL rd
+
+  int branch_pc_true = jal_pc; // as immediate is command sensitive, this also
+                               // works for b-type encoding
+
+  bprintf(f, "%d slice 2 %d %d 0\n", next_line, jal_rd, memsize - 1);
+  int branch_pc_false = next_line;
+  next_line++;
+
+  bprintf(f, ";\n; Branch Comparisons\n");
+  // comparison of every branch, BEQ to BGEU
+  const char *branch_comparisons[6] = {"eq",  "neq", "slt",
+                                       "sgte", "ult", "ugte"};
+  int branch_checks[6] = {0};
+  for (size_t i = 0; i < 6; i++) {
+    if (is_command_used(CMD_BEQ + i)) { // branches are in a row
+      bprintf(f, "%d %s 1 %d %d\n", next_line, branch_comparisons[i],
+              rs1_val_loc, rs2_val_loc);
+      branch_checks[i] = next_line;
+      next_line++;
+    }
+  }
+
+  // LOAD
+  bprintf(f, ";\n; LOAD\n");
+  int load_bytes = 0; // widest load decides how many cells have to be read
+  if (is_command_used(CMD_LB) || is_command_used(CMD_LBU)) {
+    load_bytes = 1;
+  }
+  if (is_command_used(CMD_LH) || is_command_used(CMD_LHU)) {
+    load_bytes = 2;
+  }
+  if (is_command_used(CMD_LW) || is_command_used(CMD_LWU)) {
+    load_bytes = 4;
+  }
+  if (is_command_used(CMD_LD)) {
+    load_bytes = 8;
+  }
+  int lb_rd = 0, lh_rd = 0, lw_rd = 0, ld_rd = 0, lbu_rd = 0, lhu_rd = 0,
+      lwu_rd = 0;
+  int load_address_uncut = 0;
+  if (load_bytes) {
+    bprintf(f, "%d add %d %d %d\n", next_line, register_sort, rs1_val_loc,
+            immediate_64bit);
+    int load_address = next_line;
+    load_address_uncut = load_address;
+    next_line++;
+
+    int read_bytes[8];
+    int loaded[4] = {0}; // B, H, W and D loads of word addressed memory
+    if (cell_bytes > 1) { // each width reads the cells it needs, once
+      bprintf(f, "%d slice 2 %d %d 0\n", next_line, load_address,
+              memsize - 1);
+      cell_reads c = {.memory = memory_loc, .address = next_line};
+      next_line++;
+      const int widths[4][2] = {{CMD_LB, CMD_LBU},
+                                {CMD_LH, CMD_LHU},
+                                {CMD_LW, CMD_LWU},
+                                {CMD_LD, CMD_LD}};
+      for (int i = 0; i < 4; i++) {
+        if (is_command_used(widths[i][0]) || is_command_used(widths[i][1])) {
+          next_line = btor_word_read(f, next_line, &c, 1 << i, &loaded[i]);
+        }
+      }
+      read_bytes[0] = loaded[0];
+    }
+
+    int rs1_added = next_line;
+    for (int i = 0; cell_bytes == 1 && i < load_bytes; i++) {
+      bprintf(f, "%d add %d %d %d\n", next_line, register_sort, load_address,
+              comparison_constants_loc + i);
+      next_line++;
+    }
+    int rs1_added_shortened = next_line;
+    for (int i = 0; cell_bytes == 1 && i < load_bytes; i++) {
+      bprintf(f, "%d slice 2 %d %d 0\n", next_line, rs1_added + i,
+              memsize - 1);
+      next_line++;
+    }
+
+    for (int i = 0; cell_bytes == 1 && i < load_bytes; i++) {
+      next_line = btor_read_byte(f, next_line, memory_loc,
+                                 rs1_added_shortened + i, FOOTPRINT_LOAD,
+                                 &read_bytes[i]);
+    }
+    if (is_command_used(CMD_LB)) {
+      bprintf(f, "%d sext %d %d %d lb_rd\n", next_line, register_sort,
+              read_bytes[0], xlen - 8);
+      lb_rd = next_line;
+      next_line++;
+    }
+
+    int half_cells = loaded[1];
+    if (load_bytes >= 2 && cell_bytes == 1) {
+      bprintf(f, "%d concat 4 %d %d\n", next_line, read_bytes[1],
+              read_bytes[0]);
+      half_cells = next_line;
+      next_line++;
+    }
+    if (is_command_used(CMD_LH)) {
+      bprintf(f, "%d sext %d %d %d lh_rd\n", next_line, register_sort,
+              half_cells, xlen - 16);
+      lh_rd = next_line;
+      next_line++;
+    }
+
+    int word_cells = loaded[2];
+    if (load_bytes >= 4 && cell_bytes == 1) {
+      bprintf(f, "%d concat 4 %d %d\n", next_line, read_bytes[3],
+              read_bytes[2]);
+      bprintf(f, "%d concat 5 %d %d\n", next_line + 1, next_line, half_cells);
+      word_cells = next_line + 1;
+      next_line += 2;
+    }
+    if (load_bytes >= 4) {
+      if (is_command_used(CMD_LW) && xlen == 32) {
+        lw_rd = word_cells; // the whole register
+      } else if (is_command_used(CMD_LW)) {
+        bprintf(f, "%d sext 6 %d 32 lw_rd\n", next_line, word_cells);
+        lw_rd = next_line;
+        next_line++;
+      }
+    }
+
+    ld_rd = loaded[3];
+    if (load_bytes == 8 && cell_bytes == 1) {
+      bprintf(f, "%d concat 4 %d %d\n", next_line, read_bytes[5],
+              read_bytes[4]);
+      bprintf(f, "%d concat 4 %d %d\n", next_line + 1, read_bytes[7],
+              read_bytes[6]);
+      bprintf(f, "%d concat 5 %d %d\n", next_line + 2, next_line + 1,
+              next_line);
+      bprintf(f, "%d concat 6 %d %d ld_rd\n", next_line + 3, next_line + 2,
+              word_cells);
+      ld_rd = next_line + 3;
+      next_line += 4;
+    }
+
+    if (is_command_used(CMD_LBU)) {
+      bprintf(f, "%d uext %d %d %d lbu\n", next_line, register_sort,
+              read_bytes[0], xlen - 8);
+      lbu_rd = next_line;
+      next_line++;
+    }
+
+    if (is_command_used(CMD_LHU)) {
+      bprintf(f, "%d uext %d %d %d lhu\n", next_line, register_sort,
+              half_cells, xlen - 16);
+      lhu_rd = next_line;
+      next_line++;
+    }
+
+    if (is_command_used(CMD_LWU)) {
+      bprintf(f, "%d uext 6 %d 32 lwu_rd\n", next_line, word_cells);
+      lwu_rd = next_line;
+      next_line++;
+    }
+  }
+
+  if (load_bytes && address_range_check) {
+    const int load_commands[7] = {CMD_LB, CMD_LBU, CMD_LH, CMD_LHU,
+                                  CMD_LW, CMD_LWU, CMD_LD};
+    const int load_widths[7] = {1, 1, 2, 2, 4, 4, 8};
+    next_line = btor_access_out_of_range(
+        f, next_line, load_address_uncut, address_limit,
+        comparison_constants_loc, load_commands, load_widths, 7, command_locs,
+        &range_checks[n_range_checks]);
+    n_range_checks++;
+  }
+
+  // STORE
+  bprintf(f, ";\n; STORE\n");
+  int store_bytes = 0; // widest store decides the length of the write chain
+  if (is_command_used(CMD_SB)) {
+    store_bytes = 1;
+  }
+  if (is_command_used(CMD_SH)) {
+    store_bytes = 2;
+  }
+  if (is_command_used(CMD_SW)) {
+    store_bytes = 4;
+  }
+  if (is_command_used(CMD_SD)) {
+    store_bytes = 8;
+  }
+  int sb_mem = 0, sh_mem = 0, sw_mem = 0, sd_mem = 0;
+  int store_memory = memory_loc; // memory after any store
+  if (store_bytes) {
+    int store_memory_bytes = next_line;
+    for (int i = 0; cell_bytes == 1 && i < store_bytes; i++) {
+      bprintf(f, "%d slice 3 %d %d %d\n", next_line, rs2_val_loc, 8 * i + 7,
+              8 * i); // Store byte i+1
+      next_line++;
+    }
+
+    int mem_address_consts_loc = next_line;
+    bprintf(f, "%d one 2\n", next_line);
+    next_line++;
+
+    bprintf(f, "%d add %d %d %d mem_adress_uncut\n", next_line,
+            register_sort, rs1_val_loc,
+            immediate_64bit); // Add rs1 value to immediate
+    bprintf(f, "%d slice 2 %d %d 0 mem_address\n", next_line + 1, next_line,
+            memsize - 1); // Cut to BTOR memory size
+    int store_address = next_line;
+    int mem_address_cut = next_line + 1;
+    next_line += 2;
+    for (int i = 0; i < store_bytes; i++) {
+      bprintf(f, "%d add 2 %d %d mem_address+%d\n", next_line, next_line - 1,
+              mem_address_consts_loc, i);
+      next_line++;
+    }
+
+    // byte i is written by all stores wider than i
+    int store_widths[4] = {1, 2, 4, 8};
+    int store_commands[4] = {CMD_SB, CMD_SH, CMD_SW, CMD_SD};
+    int byte_enabled[8];
+    for (int i = 0; (!store_select || memory_regions) && i < store_bytes;
+         i++) {
+      int writers[4];
+      int n_writers = 0;
+      for (size_t j = 0; j < 4; j++) {
+        if (store_widths[j] > i && is_command_used(store_commands[j])) {
+          writers[n_writers] = command_locs[store_commands[j]];
+          n_writers++;
+        }
+      }
+      next_line =
+          btor_or_list(f, next_line, writers, n_writers, &byte_enabled[i]);
+    }
+
+    const char *store_names[8] = {" sb", " sh", "", " sw",
+                                  "",    "",    "", " sd"};
+    if (!store_select && cell_bytes == 1) {
+      // A single chain for every step, bytes that are not stored are written
+      // back unchanged
+      for (int i = 0; i < store_bytes; i++) { // Store byte i+1
+        next_line = btor_write_byte(f, next_line, memory_loc, store_memory,
+                                    mem_address_cut + i,
+                                    store_memory_bytes + i, byte_enabled[i],
+                                    store_names[i], &store_memory);
+      }
+    } else if (!store_select) {
+      // The stored bytes are masked by the width of the store
+      int previous_mask = 8; // no store, nothing is written
+      const char *mask_values[4] = {"ff", "ffff", "ffffffff",
+                                    "ffffffffffffffff"};
+      for (size_t i = 0; i < 4; i++) {
+        if (is_command_used(store_commands[i])) {
+          bprintf(f, "%d consth %d %s\n", next_line, register_sort,
+                  mask_values[i]);
+          bprintf(f, "%d ite %d %d %d %d%s_mask\n", next_line + 1,
+                  register_sort, command_locs[store_commands[i]], next_line,
+                  previous_mask, store_names[store_widths[i] - 1]);
+          previous_mask = next_line + 1;
+          next_line += 2;
+        }
+      }
+      cell_reads c = {.memory = memory_loc, .address = mem_address_cut};
+      next_line = btor_word_write(f, next_line, &c, store_bytes, rs2_val_loc,
+                                  previous_mask, &store_memory);
+    } else if (cell_bytes == 1) {
+      int store_chain = next_line; // first write of the chain
+      int previous_memory = memory_loc;
+      for (int i = 0; i < store_bytes; i++) {
+        bprintf(f, "%d write 7 %d %d %d%s\n", next_line, previous_memory,
+                mem_address_cut + i, store_memory_bytes + i,
+                store_names[i]); // Store byte i+1
+        previous_memory = next_line;
+        next_line++;
+      }
+      sb_mem = store_chain;
+      sh_mem = store_chain + 1;
+      sw_mem = store_chain + 3;
+      sd_mem = store_chain + 7;
+    } else { // every width rewrites the cells it touches
+      int *store_memories[4] = {&sb_mem, &sh_mem, &sw_mem, &sd_mem};
+      cell_reads c = {.memory = memory_loc, .address = mem_address_cut};
+      for (size_t i = 0; i < 4; i++) {
+        if (is_command_used(store_commands[i])) {
+          next_line = btor_word_write(f, next_line, &c, 1 << i, rs2_val_loc,
+                                      0, store_memories[i]);
+        }
+      }
+    }
+
+    if (memory_regions) {
+      bprintf(f, ";\n; Check for stores into code memory\n");
+      bprintf(f, "%d constd 2 %ld code_start\n", next_line, code_start);
+      bprintf(f, "%d constd 2 %ld code_last_byte\n", next_line + 1,
+              code_end - 1);
+      int code_bounds = next_line;
+      next_line += 2;
+
+      int hits[8];
+      for (int i = 0; i < store_bytes; i++) {
+        bprintf(f, "%d ugte 1 %d %d\n", next_line, mem_address_cut + i,
+                code_bounds);
+        bprintf(f, "%d ulte 1 %d %d\n", next_line + 1, mem_address_cut + i,
+                code_bounds + 1);
+        bprintf(f, "%d and 1 %d %d\n", next_line + 2, next_line,
+                next_line + 1);
+        bprintf(f, "%d and 1 %d %d store_byte%d_in_code\n", next_line + 3,
+                next_line + 2, byte_enabled[i], i);
+        hits[i] = next_line + 3;
+        next_line += 4;
+      }
+      next_line = btor_or_list(f, next_line, hits, store_bytes,
+                               store_to_code_loc);
+    }
+
+    if (address_range_check) {
+      const int store_widths[4] = {1, 2, 4, 8};
+      next_line = btor_access_out_of_range(
+          f, next_line, store_address, address_limit,
+          comparison_constants_loc, store_commands, store_widths, 4,
+          command_locs, &range_checks[n_range_checks]);
+      n_range_checks++;
+    }
+  }
+
+  // MATH i
+  bprintf(f, ";\n; MATH immediate\n");
+  int math_i_rd_addi = 0;
+  if (is_command_used(CMD_ADDI)) {
+    math_i_rd_addi = next_line;
+    bprintf(f, "%d add %d %d %d addi_rd\n", next_line, register_sort,
+            rs1_val_loc, immediate_64bit); // ADDI
+    next_line++;
+  }
+
+  int immediate_6bit_shamt = 0;
+  if (is_command_used(CMD_SLLI) || is_command_used(CMD_SRLI) ||
+      is_command_used(CMD_SRAI)) {
+    immediate_6bit_shamt = next_line + 1;
+    bprintf(f, "%d consth %d %x\n", next_line, register_sort, xlen - 1);
+    bprintf(f, "%d and %d %d %d\n", next_line + 1, register_sort,
+            immediate_64bit, next_line);
+    next_line += 2;
+  }
+
+  int math_i_rd_slli = 0;
+  if (is_command_used(CMD_SLLI)) {
+    math_i_rd_slli = next_line;
+    bprintf(f, "%d sll %d %d %d slli_rd\n", next_line, register_sort,
+            rs1_val_loc, immediate_6bit_shamt); // SLLI
+    next_line++;
+  }
+
+  int math_i_rd_slti = 0;
+  if (is_command_used(CMD_SLTI)) {
+    math_i_rd_slti = next_line + 1;
+    bprintf(f, "%d slt 1 %d %d slti_rd\n", next_line, rs1_val_loc,
+            immediate_64bit);
+    bprintf(f, "%d uext %d %d %d slti_rd\n", next_line + 1, register_sort,
+            next_line, xlen - 1); // SLTI
+    next_line += 2;
+  }
+
+  int math_i_rd_sltiu = 0;
+  if (is_command_used(CMD_SLTIU)) {
+    math_i_rd_sltiu = next_line + 1;
+    bprintf(f, "%d ult 1 %d %d sltiu_rd\n", next_line, rs1_val_loc,
+            immediate_64bit);
+    bprintf(f, "%d uext %d %d %d sltiu_rd\n", next_line + 1, register_sort,
+            next_line, xlen - 1); // SLTIU
+    next_line += 2;
+  }
+
+  int math_i_rd_xori = 0;
+  if (is_command_used(CMD_XORI)) {
+    math_i_rd_xori = next_line;
+    bprintf(f, "%d xor %d %d %d xori_rd\n", next_line, register_sort,
+            rs1_val_loc, immediate_64bit); // XORI
+    next_line++;
+  }
+
+  int math_i_rd_srli = 0;
+  if (is_command_used(CMD_SRLI)) {
+    math_i_rd_srli = next_line;
+    bprintf(f, "%d srl %d %d %d srli_rd\n", next_line, register_sort,
+            rs1_val_loc, immediate_6bit_shamt); // SRLI
+    next_line++;
+  }
+
+  int math_i_rd_srai = 0;
+  if (is_command_used(CMD_SRAI)) {
+    math_i_rd_srai = next_line + 1;
+    bprintf(f, "%d sub %d %d %d srai_rd\n", next_line, register_sort,
+            immediate_64bit,
+            comparison_constants_loc + 32); // -32 removes the bit in funct7
+                                            // wich differentiates SRAI from
+                                            // SRLI
+    bprintf(f, "%d sra %d %d %d srai_rd\n", next_line + 1, register_sort,
+            rs1_val_loc, immediate_6bit_shamt); // SRAI
+    next_line += 2;
+  }
+
+  int math_i_rd_ori = 0;
+  if (is_command_used(CMD_ORI)) {
+    math_i_rd_ori = next_line;
+    bprintf(f, "%d or %d %d %d ori_rd\n", next_line, register_sort, rs1_val_loc,
+            immediate_64bit); // ORI
+    next_line++;
+  }
+
+  int math_i_rd_andi = 0;
+  if (is_command_used(CMD_ANDI)) {
+    math_i_rd_andi = next_line;
+    bprintf(f, "%d and %d %d %d andi_rd\n", next_line, register_sort,
+            rs1_val_loc, immediate_64bit); // ANDI
+    next_line++;
+  }
+
+  // MATH reg
+  bprintf(f, ";\n; MATH Register based\n");
+  int math_reg_rd_add = 0;
+  if (is_command_used(CMD_ADD)) {
+    math_reg_rd_add = next_line;
+    bprintf(f, "%d add %d %d %d add_rd\n", next_line, register_sort,
+            rs1_val_loc, rs2_val_loc); // ADD
+    next_line++;
+  }
+
+  int math_reg_rd_sub = 0;
+  if (is_command_used(CMD_SUB)) {
+    math_reg_rd_sub = next_line;
+    bprintf(f, "%d sub %d %d %d sub_rd\n", next_line, register_sort,
+            rs1_val_loc, rs2_val_loc); // SUB
+    next_line++;
+  }
+
+  int rs2_shamt_loc = 0;
+  if (is_command_used(CMD_SLL) || is_command_used(CMD_SRL) ||
+      is_command_used(CMD_SRA)) {
+    bprintf(f, "%d consth %d %x\n", next_line, register_sort, xlen - 1);
+    bprintf(f, "%d and %d %d %d\n", next_line + 1, register_sort, rs2_val_loc,
+            next_line);
+    rs2_shamt_loc =
+        next_line + 1; // rs2 shamt is the lower 6 bits of rs2_val_cut_loc
+    next_line += 2;
+  }
+
+  int math_reg_rd_sll = 0;
+  if (is_command_used(CMD_SLL)) {
+    math_reg_rd_sll = next_line;
+    bprintf(f, "%d sll %d %d %d sll_rd\n", next_line, register_sort,
+            rs1_val_loc, rs2_shamt_loc); // SLL
+    next_line++;
+  }
+
+  int math_reg_rd_slt = 0;
+  if (is_command_used(CMD_SLT)) {
+    math_reg_rd_slt = next_line + 1;
+    bprintf(f, "%d slt 1 %d %d slt_rd\n", next_line, rs1_val_loc,
+            rs2_val_loc);
+    bprintf(f, "%d uext %d %d %d slt_rd\n", next_line + 1, register_sort,
+            next_line, xlen - 1); // SLT
+    next_line += 2;
+  }
+
+  int math_reg_rd_sltu = 0;
+  if (is_command_used(CMD_SLTU)) {
+    math_reg_rd_sltu = next_line + 1;
+    bprintf(f, "%d ult 1 %d %d sltu_rd\n", next_line, rs1_val_loc,
+            rs2_val_loc);
+    bprintf(f, "%d uext %d %d %d sltu_rd\n", next_line + 1, register_sort,
+            next_line, xlen - 1); // SLTU
+    next_line += 2;
+  }
+
+  int math_reg_rd_xor = 0;
+  if (is_command_used(CMD_XOR)) {
+    math_reg_rd_xor = next_line;
+    bprintf(f, "%d xor %d %d %d xor_rd\n", next_line, register_sort,
+            rs1_val_loc, rs2_val_loc); // XOR
+    next_line++;
+  }
+
+  int math_reg_rd_srl = 0;
+  if (is_command_used(CMD_SRL)) {
+    math_reg_rd_srl = next_line;
+    bprintf(f, "%d srl %d %d %d srl_rd\n", next_line, register_sort,
+            rs1_val_loc, rs2_shamt_loc); // SRL
+    next_line++;
+  }
+
+  int math_reg_rd_sra = 0;
+  if (is_command_used(CMD_SRA)) {
+    math_reg_rd_sra = next_line;
+    bprintf(f, "%d sra %d %d %d sra_rd\n", next_line, register_sort,
+            rs1_val_loc, rs2_shamt_loc); // SRA
+    next_line++;
+  }
+
+  int math_reg_rd_or = 0;
+  if (is_command_used(CMD_OR)) {
+    math_reg_rd_or = next_line;
+    bprintf(f, "%d or %d %d %d or_rd\n", next_line, register_sort, rs1_val_loc,
+            rs2_val_loc); // OR
+    next_line++;
+  }
+
+  int math_reg_rd_and = 0;
+  if (is_command_used(CMD_AND)) {
+    math_reg_rd_and = next_line;
+    bprintf(f, "%d and %d %d %d and_rd\n", next_line, register_sort,
+            rs1_val_loc, rs2_val_loc); // AND
+    next_line++;
+  }
+
+  // MATH WI
+  bprintf(f, ";\n; MATH Word Immediate\n");
+
+  int rs1_val_cut_loc = 0;
+  for (int i = CMD_ADDIW; i <= CMD_SRAW; i++) { // all word commands use rs1
+    if (is_command_used(i)) {
+      bprintf(f, "%d slice 5 %d 31 0\n", next_line,
+              rs1_val_loc); // rs1 cut to 32 bit
+      rs1_val_cut_loc = next_line;
+      next_line++;
+      break;
+    }
+  }
+
+  int math_iw_rd_addiw = 0;
+  if (is_command_used(CMD_ADDIW)) {
+    bprintf(f, "%d add 5 %d %d\n", next_line, rs1_val_cut_loc,
+            immediate_loc); // ADDIW
+    bprintf(f, "%d sext 6 %d 32 addiw_rd\n", next_line + 1, next_line);
+    math_iw_rd_addiw = next_line + 1;
+    next_line += 2;
+  }
+
+  int math_iw_rd_slliw = 0;
+  if (is_command_used(CMD_SLLIW)) {
+    bprintf(f, "%d sll 5 %d %d\n", next_line, rs1_val_cut_loc,
+            codes[3]); // SLLIW, shamt is exactly at the place of rs2 encoding
+    bprintf(f, "%d sext 6 %d 32 slliw_rd\n", next_line + 1, next_line);
+    math_iw_rd_slliw = next_line + 1;
+    next_line += 2;
+  }
+
+  int math_iw_rd_srliw = 0;
+  if (is_command_used(CMD_SRLIW)) {
+    bprintf(f, "%d srl 5 %d %d\n", next_line, rs1_val_cut_loc,
+            codes[3]); // SRLIW
+    bprintf(f, "%d sext 6 %d 32 srliw_rd\n", next_line + 1, next_line);
+    math_iw_rd_srliw = next_line + 1;
+    next_line += 2;
+  }
+
+  int math_iw_rd_sraiw = 0;
+  if (is_command_used(CMD_SRAIW)) {
+    bprintf(f, "%d sra 5 %d %d\n", next_line, rs1_val_cut_loc,
+            codes[3]); // SRAIW
+    bprintf(f, "%d sext 6 %d 32 sraiw_rd\n", next_line + 1, next_line);
+    math_iw_rd_sraiw = next_line + 1;
+    next_line += 2;
+  }
+
+  bprintf(f, ";\n; MATH Word\n");
+
+  int rs2_val_cut_loc = 0;
+  for (int i = CMD_ADDW; i <= CMD_SRAW; i++) { // register word commands
+    if (is_command_used(i)) {
+      bprintf(f, "%d slice 5 %d 31 0\n", next_line,
+              rs2_val_loc); // rs2 cut to 32 bit
+      rs2_val_cut_loc = next_line;
+      next_line++;
+      break;
+    }
+  }
+
+  int math_w_rd_addw = 0;
+  if (is_command_used(CMD_ADDW)) {
+    bprintf(f, "%d add 5 %d %d\n", next_line, rs1_val_cut_loc,
+            rs2_val_cut_loc); // ADDW
+    bprintf(f, "%d sext 6 %d 32 addw_rd\n", next_line + 1, next_line);
+    math_w_rd_addw = next_line + 1;
+    next_line += 2;
+  }
+
+  int math_w_rd_subw = 0;
+  if (is_command_used(CMD_SUBW)) {
+    bprintf(f, "%d sub 5 %d %d\n", next_line, rs1_val_cut_loc,
+            rs2_val_cut_loc); // SUBW
+    bprintf(f, "%d sext 6 %d 32 subw_rd\n", next_line + 1, next_line);
+    math_w_rd_subw = next_line + 1;
+    next_line += 2;
+  }
+
+  int rs2_w_shamt_loc = 0;
+  if (is_command_used(CMD_SLLW) || is_command_used(CMD_SRLW) ||
+      is_command_used(CMD_SRAW)) {
+    bprintf(f, "%d consth 5 1f\n", next_line);
+    bprintf(f, "%d and 5 %d %d\n", next_line + 1, rs2_val_cut_loc, next_line);
+    rs2_w_shamt_loc =
+        next_line + 1; // rs2 shamt is the lower 6 bits of rs2_val_cut_loc
+    next_line += 2;
+  }
+
+  int math_w_rd_sllw = 0;
+  if (is_command_used(CMD_SLLW)) {
+    bprintf(f, "%d sll 5 %d %d\n", next_line, rs1_val_cut_loc,
+            rs2_w_shamt_loc); // SLLW
+    bprintf(f, "%d sext 6 %d 32 sllw_rd\n", next_line + 1, next_line);
+    math_w_rd_sllw = next_line + 1;
+    next_line += 2;
+  }
+
+  int math_w_rd_srlw = 0;
+  if (is_command_used(CMD_SRLW)) {
+    bprintf(f, "%d srl 5 %d %d\n", next_line, rs1_val_cut_loc,
+            rs2_w_shamt_loc); // SRLW
+    bprintf(f, "%d sext 6 %d 32 srlw_rd\n", next_line + 1, next_line);
+    math_w_rd_srlw = next_line + 1;
+    next_line += 2;
+  }
+
+  int math_w_rd_sraw = 0;
+  if (is_command_used(CMD_SRAW)) {
+    bprintf(f, "%d sra 5 %d %d\n", next_line, rs1_val_cut_loc,
+            rs2_w_shamt_loc); // SRAW
+    bprintf(f, "%d sext 6 %d 32 sraw_rd\n", next_line + 1, next_line);
+    math_w_rd_sraw = next_line + 1;
+    next_line += 2;
+  }
+
+  // {command, value for rd, name} of every command writing rd, in the order
+  // the ite chain checks them
+  struct {
+    command_index command;
+    int rd_value;
+    const char *name;
+  } rd_writers[] = {
+      {CMD_LUI, lui_rd, "lui"},
+      {CMD_AUIPC, auipc_rd, "auipc"},
+      {CMD_JAL, jal_rd, "jal"},
+      {CMD_JALR, jalr_rd, "jalr"},
+      {CMD_LB, lb_rd, "lb"},
+      {CMD_LH, lh_rd, "lh"},
+      {CMD_LW, lw_rd, "lw"},
+      {CMD_LD, ld_rd, "ld"},
+      {CMD_LBU, lbu_rd, "lbu"},
+      {CMD_LHU, lhu_rd, "lhu"},
+      {CMD_LWU, lwu_rd, "lwu"},
+      {CMD_ADDI, math_i_rd_addi, "addi"},
+      {CMD_SLLI, math_i_rd_slli, "slli"},
+      {CMD_SLTI, math_i_rd_slti, "slti"},
+      {CMD_SLTIU, math_i_rd_sltiu, "sltiu"},
+      {CMD_XORI, math_i_rd_xori, "xori"},
+      {CMD_SRLI, math_i_rd_srli, "srli"},
+      {CMD_SRAI, math_i_rd_srai, "srai"},
+      {CMD_ORI, math_i_rd_ori, "ori"},
+      {CMD_ANDI, math_i_rd_andi, "andi"},
+      {CMD_ADD, math_reg_rd_add, "add"},
+      {CMD_SUB, math_reg_rd_sub, "sub"},
+      {CMD_SLL, math_reg_rd_sll, "sll"},
+      {CMD_SLT, math_reg_rd_slt, "slt"},
+      {CMD_SLTU, math_reg_rd_sltu, "sltu"},
+      {CMD_XOR, math_reg_rd_xor, "xor"},
+      {CMD_SRL, math_reg_rd_srl, "srl"},
+      {CMD_SRA, math_reg_rd_sra, "sra"},
+      {CMD_OR, math_reg_rd_or, "or"},
+      {CMD_AND, math_reg_rd_and, "and"},
+      {CMD_ADDIW, math_iw_rd_addiw, "addiw"},
+      {CMD_SLLIW, math_iw_rd_slliw, "slliw"},
+      {CMD_SRLIW, math_iw_rd_srliw, "srliw"},
+      {CMD_SRAIW, math_iw_rd_sraiw, "sraiw"},
+      {CMD_ADDW, math_w_rd_addw, "addw"},
+      {CMD_SUBW, math_w_rd_subw, "subw"},
+      {CMD_SLLW, math_w_rd_sllw, "sllw"},
+      {CMD_SRLW, math_w_rd_srlw, "srlw"},
+      {CMD_SRAW, math_w_rd_sraw, "sraw"}};
+  size_t n_rd_writers = sizeof(rd_writers) / sizeof(rd_writers[0]);
+
+  int rd_value = 0;
+  int writes_rd = 0;
+  int is_branch_store = 0;
+  if (shared_writeback || register_array) {
+    // The value for rd is the same for every register, so only select it once
+    bprintf(f, ";\n; Value for rd\n");
+    int previous_value = 8; // no command with rd, never written
+    int writer_checks[sizeof(rd_writers) / sizeof(rd_writers[0])];
+    int n_writer_checks = 0;
+    for (size_t j = 0; j < n_rd_writers; j++) {
+      if (!is_command_used(rd_writers[j].command)) {
+        continue;
+      }
+      bprintf(f, "%d ite %d %d %d %d rd_%s\n", next_line, register_sort,
+              command_locs[rd_writers[j].command], rd_writers[j].rd_value,
+              previous_value, rd_writers[j].name);
+      previous_value = next_line;
+      next_line++;
+      writer_checks[n_writer_checks] = command_locs[rd_writers[j].command];
+      n_writer_checks++;
+    }
+    rd_value = previous_value;
+    next_line = btor_or_list(f, next_line, writer_checks, n_writer_checks,
+                             &writes_rd);
+    // Test if command is Branch or Store
+    bprintf(f, "%d or 1 %d %d opcode_is_branch_store\n", next_line,
+            opcode_comp + 4, opcode_comp + 8);
+    is_branch_store = next_line;
+    next_line++;
+  }
+
+  new_registers[0] = registers[0]; // x0 is never written
+  new_flags[0] = 16;                 // and always initialised
+  if (register_array) {
+    bprintf(f, ";\n; Update register file\n");
+    bprintf(f, "%d zero 18\n", next_line);
+    bprintf(f, "%d neq 1 %d %d\n", next_line + 1, rd_code, next_line);
+    bprintf(f, "%d and 1 %d %d rd_written\n", next_line + 2, next_line + 1,
+            writes_rd);
+    bprintf(f, "%d read %d %d %d\n", next_line + 3, register_sort,
+            registers[0], rd_code);
+    bprintf(f, "%d ite %d %d %d %d\n", next_line + 4, register_sort,
+            next_line + 2, rd_value, next_line + 3);
+    bprintf(f, "%d write %d %d %d %d registers_new\n", next_line + 5,
+            register_file_sort, registers[0], rd_code, next_line + 4);
+    new_registers[0] = next_line + 5;
+    next_line += 6;
+  }
+  for (size_t i = 1; i < 32; i++) {
+    bprintf(f, ";\n; Update register x%ld\n", i);
+    int is_rd = next_line;
+    bprintf(f, "%d eq 1 %ld %d x%ld_is_rd\n", next_line,
+            register_code_consts + i, rd_code, i);
+    next_line++;
+
+    if (register_array) {
+      bprintf(f, "; Update init-flag\n");
+      bprintf(f, "%d ite 1 -%d 16 %d command_check\n", next_line,
+              is_branch_store,
+              reg_flags[i]); // only if not branch or store
+      bprintf(f, "%d ite 1 %d %d %d rd_check\n", next_line + 1, is_rd,
+              next_line, reg_flags[i]);
+      new_flags[i] = next_line + 1;
+      next_line += 2;
+      continue;
+    }
+
+    if (shared_writeback) {
+      bprintf(f, "%d and 1 %d %d x%ld_written\n", next_line, is_rd,
+              writes_rd, i);
+      bprintf(f, "%d ite %d %d %d %d x%ld_new\n", next_line + 1,
+              register_sort, next_line, rd_value, registers[i], i);
+      new_registers[i] = next_line + 1;
+      bprintf(f, ";Also update init-flag\n");
+      bprintf(f, "%d ite 1 -%d 16 %d command_check\n", next_line + 2,
+              is_branch_store,
+              reg_flags[i]); // only if not branch or store
+      bprintf(f, "%d ite 1 %d %d %d rd_check\n", next_line + 3, is_rd,
+              next_line + 2, reg_flags[i]);
+      new_flags[i] = next_line + 3;
+      next_line += 4;
+      continue;
+    }
+
+    int previous_value = registers[i]; // command without rd
+    for (size_t j = 0; j < n_rd_writers; j++) {
+      if (!is_command_used(rd_writers[j].command)) {
+        continue;
+      }
+      bprintf(f, "%d ite %d %d %d %d x%ld_%s\n", next_line, register_sort,
+              command_locs[rd_writers[j].command], rd_writers[j].rd_value,
+              previous_value, i, rd_writers[j].name);
+      previous_value = next_line;
+      next_line++;
+    }
+
+    bprintf(f, "%d ite %d %d %d %d x%ld_new\n", next_line, register_sort,
+            is_rd, previous_value, registers[i], i); // check if xi is rd
+    new_registers[i] = next_line;
+    bprintf(f, ";Also update init-flag\n");
+    // Test if command is Branch or Store
+    bprintf(f, "%d or 1 %d %d opcode_is_branch_store\n", next_line + 1,
+            opcode_comp + 4, opcode_comp + 8);
+    bprintf(f, "%d ite 1 -%d 16 %d command_check\n", next_line + 2,
+            next_line + 1,
+            reg_flags[i]); // only if not branch or store
+    bprintf(f, "%d ite 1 %d %d %d rd_check\n", next_line + 3, is_rd,
+            next_line + 2, reg_flags[i]);
+    new_flags[i] = next_line + 3;
+
+    next_line += 4;
+  }
+  bprintf(f, ";\n; Update PC\n");
+  const char *branch_names[6] = {"beq", "bne", "blt", "bge", "bltu", "bgeu"};
+  int branch_deciders[6] = {0};
+  for (size_t i = 0; i < 6; i++) {
+    if (is_command_used(CMD_BEQ + i)) {
+      bprintf(f, "%d ite 2 %d %d %d pc_%s_decider\n", next_line,
+              branch_checks[i], branch_pc_true, branch_pc_false,
+              branch_names[i]);
+      branch_deciders[i] = next_line;
+      next_line++;
+    }
+  }
+
+  int previous_pc = branch_pc_false;
+  if (is_command_used(CMD_JAL)) {
+    bprintf(f, "%d ite 2 %d %d %d pc_jal\n", next_line, command_locs[CMD_JAL],
+            jal_pc, previous_pc);
+    previous_pc = next_line;
+    next_line++;
+  }
+  if (is_command_used(CMD_JALR)) {
+    bprintf(f, "%d ite 2 %d %d %d pc_jalr\n", next_line,
+            command_locs[CMD_JALR], jalr_pc, previous_pc);
+    previous_pc = next_line;
+    next_line++;
+  }
+
+  for (size_t i = 0; i < 6; i++) {
+    if (is_command_used(CMD_BEQ + i)) {
+      bprintf(f, "%d ite 2 %d %d %d pc_%s\n", next_line,
+              command_locs[CMD_BEQ + i], branch_deciders[i], previous_pc,
+              branch_names[i]);
+      previous_pc = next_line;
+      next_line++;
+    }
+  }
+  new_registers[32] = previous_pc;
+
+  if (address_range_check) {
+    // The same choice on the full width, before it is cut to the memory
+    bprintf(f, "; Check the next pc before it wraps around\n");
+    int full_deciders[6] = {0};
+    for (size_t i = 0; i < 6; i++) {
+      if (is_command_used(CMD_BEQ + i)) {
+        bprintf(f, "%d ite %d %d %d %d\n", next_line, register_sort,
+                branch_checks[i], pc_immediate_added, jal_rd);
+        full_deciders[i] = next_line;
+        next_line++;
+      }
+    }
+    int full_pc = jal_rd;
+    if (is_command_used(CMD_JAL)) {
+      bprintf(f, "%d ite %d %d %d %d\n", next_line, register_sort,
+              command_locs[CMD_JAL], pc_immediate_added, full_pc);
+      full_pc = next_line;
+      next_line++;
+    }
+    if (is_command_used(CMD_JALR)) {
+      bprintf(f, "%d ite %d %d %d %d\n", next_line, register_sort,
+              command_locs[CMD_JALR], jalr_target, full_pc);
+      full_pc = next_line;
+      next_line++;
+    }
+    for (size_t i = 0; i < 6; i++) {
+      if (is_command_used(CMD_BEQ + i)) {
+        bprintf(f, "%d ite %d %d %d %d\n", next_line, register_sort,
+                command_locs[CMD_BEQ + i], full_deciders[i], full_pc);
+        full_pc = next_line;
+        next_line++;
+      }
+    }
+    bprintf(f, "%d ugte 1 %d %d pc_out_of_range\n", next_line, full_pc,
+            address_limit);
+    range_checks[n_range_checks] = next_line;
+    n_range_checks++;
+    next_line++;
+    next_line = btor_or_list(f, next_line, range_checks, n_range_checks,
+                             out_of_range_loc);
+  }
+
+  bprintf(f, ";\n; Update memory\n");
+  int previous_memory = store_memory;
+  int store_commands[4] = {CMD_SB, CMD_SH, CMD_SW, CMD_SD};
+  int store_memories[4] = {sb_mem, sh_mem, sw_mem, sd_mem};
+  const char *store_names[4] = {"sb", "sh", "sw", "sd"};
+  for (size_t i = 0; store_select && i < 4; i++) {
+    if (is_command_used(store_commands[i])) {
+      bprintf(f, "%d ite %d %d %d %d mem_%s\n", next_line, memory_sort,
+              command_locs[store_commands[i]], store_memories[i],
+              previous_memory, store_names[i]);
+      previous_memory = next_line;
+      next_line++;
+    }
+  }
+  *new_memory = previous_memory;
+
+  bprintf(f, ";\n; Some little helpers for bad command detection\n");
+  bprintf(f, "; misaligned instruction fetch error\n");
+  bprintf(f, "%d consth 2 3\n", next_line);
+  bprintf(f, "%d zero 2\n", next_line + 1);
+  int pc_consts_loc = next_line;
+  int pc_zero = next_line + 1;
+  next_line += 2;
+  bprintf(f, "%d and 2 %d %d\n", next_line, pc_consts_loc, jal_pc);
+  bprintf(f, "%d and 2 %d %d\n", next_line + 1, pc_consts_loc, jalr_pc);
+
+  bprintf(f, "%d neq 1 %d %d misaligned_jal_pc\n", next_line + 2, next_line,
+          pc_zero); // error
+  bprintf(f, "%d neq 1 %d %d misaligned_jalr_pc\n", next_line + 3,
+          next_line + 1, pc_zero); // error
+
+  bprintf(f, "%d and 1 %d %d mis_and_jal\n", next_line + 4,
+          command_locs[CMD_JAL], next_line + 2);
+  bprintf(f, "%d and 1 %d %d mis_and_jalr\n", next_line + 5,
+          command_locs[CMD_JALR], next_line + 3);
+
+  bprintf(f, "%d or 1 %d %d\n", next_line + 6, next_line + 4,
+          next_line + 5); // option jal or jalr
+  next_line += 7;
+
+  return next_line;
+}
+
+int btor_bad_counter(writer *f, int next_line, int counter_loc,
+                     int counterlimit, int *bad_locs) {
+  bprintf(f, ";\n; Bad counter\n");
+  bprintf(f, "%d constd 6 %d\n", next_line, counterlimit);
+  bprintf(f, "%d eq 1 %d %d\n", next_line + 1, counter_loc,
+          next_line); // Check if counter is equal to limit
+  bad_locs[BAD_COUNTER] = next_line + 1;
+  return next_line + 2;
+}
+int btor_bad_command(writer *f, int next_line, int *command_locs,
+                     int opcode_comp, int badstate_pretest, int *bad_locs) {
+  bprintf(f, ";\n; Bad opcode\n");
+  int opcodes[11];
+  for (int i = 0; i < 11; i++) {
+    opcodes[i] = opcode_comp + i;
+  }
+  int opcode_test_loc;
+  next_line = btor_or_list(f, next_line, opcodes, 11, &opcode_test_loc);
+
+  bprintf(f, ";\n; Bad command\n");
+  int tested_commands[COMMAND_COUNT];
+  int n_tested = 0;
+  for (int i = 0; i < COMMAND_COUNT; i++) {
+    if (is_command_used(i)) {
+      tested_commands[n_tested] = command_locs[i];
+      n_tested++;
+    }
+  }
+  int command_test_loc; // false if no command is recognised at all
+  next_line = btor_or_list(f, next_line, tested_commands, n_tested,
+                           &command_test_loc);
+  // bad if no recognised opcode is found, with a subset (or RV32) also pruned
+  // commands are unknown
+  bad_locs[BAD_UNKNOWN_OPCODE] =
+      -(isa_subset_auto || xlen == 32 ? command_test_loc : opcode_test_loc);
+  bprintf(f, "%d and 1 %d -%d\n", next_line, command_test_loc,
+          opcode_test_loc); // bad if no recognised command is found
+  bad_locs[BAD_COMMAND] = next_line;
+  next_line++;
+
+  bad_locs[BAD_MISALIGNED] = badstate_pretest; // bad if pretest is false
+  return next_line;
+}
+
+int btor_bad_halted(writer *f, int next_line, int command, int pc, int new_pc,
+                    int *bad_locs) {
+  // Halted on an all zero word, a command jumping to itself or the exit
+  bprintf(f, ";\n; Program halted\n");
+  bprintf(f, "%d zero 5\n", next_line);
+  bprintf(f, "%d eq 1 %d %d zero_command\n", next_line + 1, command,
+          next_line);
+  bprintf(f, "%d eq 1 %d %d self_loop\n", next_line + 2, pc, new_pc);
+  bprintf(f, "%d or 1 %d %d\n", next_line + 3, next_line + 1, next_line + 2);
+  bad_locs[BAD_HALTED] = next_line + 3;
+  next_line += 4;
+  if (halt_at_exit) {
+    bprintf(f, "%d consth 2 %lx exit_address\n", next_line,
+            exit_address % pow_memsize);
+    bprintf(f, "%d eq 1 %d %d\n", next_line + 1, pc, next_line);
+    bprintf(f, "%d or 1 %d %d\n", next_line + 2, bad_locs[BAD_HALTED],
+            next_line + 1);
+    bad_locs[BAD_HALTED] = next_line + 2;
+    next_line += 3;
+  }
+  return next_line;
+}
+
+int btor_bads(writer *f, int next_line, int bad_locs[][BAD_COUNT], int steps,
+              int jumped) {
+  // One bad property per kind, that holds if any step of the transition is bad
+  // and no loop was jumped over instead
+  bprintf(f, ";\n; Bad properties\n");
+  for (int kind = 0; kind < BAD_COUNT; kind++) {
+    if (kind == BAD_STORE_TO_CODE && !memory_regions) {
+      continue;
+    }
+    if (kind == BAD_OUT_OF_RANGE && !address_range_check) {
+      continue;
+    }
+    if (kind == BAD_HALTED && !halt_check) {
+      continue;
+    }
+    if (!selected_props[kind]) {
+      continue;
+    }
+    if (kind == BAD_COUNTER && instance > 0) {
+      continue; // the counter is shared
+    }
+    int checks[steps];
+    for (int step = 0; step < steps; step++) {
+      checks[step] = bad_locs[step][kind];
+    }
+    int bad_loc;
+    next_line = btor_or_list(f, next_line, checks, steps, &bad_loc);
+    if (jumped) {
+      bprintf(f, "%d and 1 %d -%d\n", next_line, bad_loc, jumped);
+      bad_loc = next_line;
+      next_line++;
+    }
+    bprintf(f, "%d bad %d %s%s\n", next_line, bad_loc,
+            kind == BAD_COUNTER ? "" : instance_name, bad_names[kind]);
+    next_line++;
+  }
+  return next_line;
+}
+
+int btor_pc_constraint(writer *f, int next_line, int pc, uint64_t *pcs,
+                       size_t n_pcs) {
+  // The pc only takes reachable values, runs of commands are checked as range
+  bprintf(f, ";\n; Reachable pcs\n");
+  int *in_run = malloc(n_pcs * sizeof(int));
+  int n_runs = 0;
+  bool ranges = false;
+  bool same_offset = true; // every pc has the same lowest two bits
+  for (size_t i = 0; i < n_pcs;) {
+    size_t last = i;
+    while (last + 1 < n_pcs &&
+           pcs[last + 1] == pcs[last] + 4) {
+      last++;
+    }
+    if (last == i) {
+      bprintf(f, "%d consth 2 %lx\n", next_line, pcs[i]);
+      bprintf(f, "%d eq 1 %d %d\n", next_line + 1, pc, next_line);
+      in_run[n_runs] = next_line + 1;
+      next_line += 2;
+    } else {
+      bprintf(f, "%d consth 2 %lx\n", next_line, pcs[i]);
+      bprintf(f, "%d consth 2 %lx\n", next_line + 1, pcs[last]);
+      bprintf(f, "%d ugte 1 %d %d\n", next_line + 2, pc, next_line);
+      bprintf(f, "%d ulte 1 %d %d\n", next_line + 3, pc, next_line + 1);
+      bprintf(f, "%d and 1 %d %d\n", next_line + 4, next_line + 2,
+              next_line + 3);
+      in_run[n_runs] = next_line + 4;
+      next_line += 5;
+      ranges = true;
+    }
+    n_runs++;
+    for (; i <= last; i++) {
+      same_offset &= (pcs[i] & 3) == (pcs[0] & 3);
+    }
+  }
+  int reachable;
+  next_line = btor_or_list(f, next_line, in_run, n_runs, &reachable);
+  free(in_run);
+  if (ranges && same_offset) { // ranges also hold the pcs between commands
+    bprintf(f, "%d consth 2 3\n", next_line);
+    bprintf(f, "%d consth 2 %lx\n", next_line + 1, pcs[0] & 3);
+    bprintf(f, "%d and 2 %d %d\n", next_line + 2, pc, next_line);
+    bprintf(f, "%d eq 1 %d %d\n", next_line + 3, next_line + 2,
+            next_line + 1);
+    bprintf(f, "%d and 1 %d %d\n", next_line + 4, reachable, next_line + 3);
+    reachable = next_line + 4;
+    next_line += 5;
+  }
+  bprintf(f, "%d constraint %d reachable_pc\n", next_line, reachable);
+  return next_line + 1;
+}
+
+int btor_step(writer *f, int next_line, int *registers, int *reg_flags,
+              int memory, int code_memory, int counter_loc, int iterations,
+              int *new_registers, int *new_flags, int *new_memory,
+              int *bad_locs, int *opcode) {
+  // Executes a single command on the given registers and memory
+  next_line = btor_get_current_command(f, next_line, registers[32],
+                                       code_memory ? code_memory : memory);
+  int command = next_line - 1;
+
+  int codes[7]; //={opcode, rd, rs1, rs2, funct3, funct7};
+  next_line = btor_get_opcode(f, next_line, command);
+  codes[0] = next_line - 1; // opcode
+  *opcode = codes[0];
+  next_line = btor_get_destination(f, next_line, command);
+  codes[1] = next_line - 1; // rd
+  next_line = btor_get_source1(f, next_line, command);
+  codes[2] = next_line - 1; // rs1
+  next_line = btor_get_source2(f, next_line, command);
+  codes[3] = next_line - 1; // rs2
+  next_line = btor_get_funct3(f, next_line, command);
+  codes[4] = next_line - 1; // funct3
+  next_line = btor_get_funct7(f, next_line, command);
+  codes[5] = next_line - 1; // funct7
+
+  next_line = btor_get_immediate(f, next_line, command, codes);
+  int immediate = next_line - 1;    // immediate
+  int opcode_comp = immediate - 19; // HACKY
+
+  int command_locs[COMMAND_COUNT];
+  next_line = btor_check_4_all_commands(f, next_line, opcode_comp, codes,
+                                        command_locs);
+
+  bad_locs[BAD_STORE_TO_CODE] = 17; // false without memory regions or stores
+  bad_locs[BAD_OUT_OF_RANGE] = 17;
+  next_line = btor_updates(f, next_line, registers, memory, command_locs,
+                           immediate, opcode_comp, codes, reg_flags,
+                           &bad_locs[BAD_STORE_TO_CODE],
+                           &bad_locs[BAD_OUT_OF_RANGE], new_registers,
+                           new_flags, new_memory);
+  int bad_helper_loc = next_line - 1;
+
+  next_line =
+      btor_bad_counter(f, next_line, counter_loc, iterations, bad_locs);
+
+  next_line = btor_bad_command(f, next_line, command_locs, opcode_comp,
+                               bad_helper_loc, bad_locs);
+  if (cell_bytes > 1 && selected_props[BAD_MISALIGNED]) {
+    // The command was fetched from the cell of an aligned pc only
+    bprintf(f, "%d consth 2 3\n", next_line);
+    bprintf(f, "%d and 2 %d %d\n", next_line + 1, registers[32], next_line);
+    bprintf(f, "%d redor 1 %d misaligned_pc\n", next_line + 2,
+            next_line + 1);
+    bprintf(f, "%d or 1 %d %d\n", next_line + 3, bad_locs[BAD_MISALIGNED],
+            next_line + 2);
+    bad_locs[BAD_MISALIGNED] = next_line + 3;
+    next_line += 4;
+  }
+  if (code_memory) {
+    // The command was fetched from the code memory, outside of it is bad
+    int pc_in_code;
+    next_line = btor_pc_in_code(f, next_line, registers[32], &pc_in_code);
+    if (selected_props[BAD_MISALIGNED]) {
+      bprintf(f, "%d or 1 %d -%d\n", next_line, bad_locs[BAD_MISALIGNED],
+              pc_in_code);
+      bad_locs[BAD_MISALIGNED] = next_line;
+    } else {
+      bprintf(f, "%d constraint %d fetch_in_code\n", next_line, pc_in_code);
+    }
+    next_line++;
+  }
+
+  bad_locs[BAD_HALTED] = 17;
+  if (halt_check) {
+    next_line = btor_bad_halted(f, next_line, command, registers[32],
+                                new_registers[32], bad_locs);
+  }
+  return next_line;
+}
+
+int btor_next_states(writer *f, int next_line, int harts,
+                     int registers[][33], int reg_flags[][32], int memory,
+                     int new_registers[][33], int new_flags[][32],
+                     int new_memory) {
+  bprintf(f, ";\n; Next states\n");
+  for (int hart = 0; hart < harts; hart++) {
+    if (register_array) {
+      bprintf(f, "%d next %d %d %d registers_new\n", next_line,
+              register_file_sort, registers[hart][0], new_registers[hart][0]);
+      next_line++;
+    }
+    for (size_t i = 0; i < 32; i++) {
+      if (!register_array) {
+        bprintf(f, "%d next %d %d %d x%ld_new\n", next_line, register_sort,
+                registers[hart][i], new_registers[hart][i], i);
+        next_line++;
+      }
+      bprintf(f, "%d next 1 %d %d reg_init_flag_new\n", next_line,
+              reg_flags[hart][i], new_flags[hart][i]);
+      next_line++;
+    }
+    bprintf(f, "%d next 2 %d %d pc_new\n", next_line, registers[hart][32],
+            new_registers[hart][32]);
+    next_line++;
+  }
+  if (!scalar_cells) {
+    bprintf(f, "%d next %d %d %d memory_new\n", next_line, memory_sort,
+            memory, new_memory);
+    return next_line + 1;
+  }
+  for (size_t i = 0; i < scalar_cells; i++) {
+    bprintf(f, "%d next 3 %d %d\n", next_line, scalar_cell(memory, i),
+            scalar_cell(new_memory, i));
+    next_line++;
+  }
+  return next_line;
+}
+
+bool is_register_state(int i) {
+  // A register file only has the array at 0 and the pc at 32
+  return !register_array || i == 0 || i == 32;
+}
+
+int register_state_sort(int i) {
+  if (i == 32) {
+    return 2;
+  }
+  return register_array ? register_file_sort : register_sort;
+}
+
+int btor_scheduler(writer *f, int next_line, int harts, int registers[][33],
+                   int flags[][32], int *scheduled, int *picked,
+                   int *current_registers, int *current_flags) {
+  // An input picks the hart, whose registers the command works on
+  bprintf(f, ";\n; Scheduler, picks the hart of the transition\n");
+  int bits = 1;
+  while ((1 << bits) < harts) {
+    bits++;
+  }
+  bprintf(f, "%d sort bitvec %d Hart\n", next_line, bits);
+  bprintf(f, "%d input %d %sscheduler\n", next_line + 1, next_line,
+          instance_name);
+  int hart_sort = next_line;
+  *scheduled = next_line + 1;
+  next_line += 2;
+  if (harts < (1 << bits)) {
+    bprintf(f, "%d constd %d %d\n", next_line, hart_sort, harts - 1);
+    bprintf(f, "%d ulte 1 %d %d\n", next_line + 1, *scheduled, next_line);
+    bprintf(f, "%d constraint %d %svalid_hart\n", next_line + 2,
+            next_line + 1, instance_name);
+    next_line += 3;
+  }
+  for (int hart = 0; hart < harts; hart++) {
+    bprintf(f, "%d constd %d %d\n", next_line, hart_sort, hart);
+    bprintf(f, "%d eq 1 %d %d picked_hart%d\n", next_line + 1, *scheduled,
+            next_line, hart);
+    picked[hart] = next_line + 1;
+    next_line += 2;
+  }
+  for (int i = 0; i < 33; i++) {
+    if (!is_register_state(i)) {
+      continue;
+    }
+    current_registers[i] = registers[harts - 1][i];
+    for (int hart = harts - 2; hart >= 0; hart--) {
+      bprintf(f, "%d ite %d %d %d %d\n", next_line, register_state_sort(i),
+              picked[hart], registers[hart][i], current_registers[i]);
+      current_registers[i] = next_line;
+      next_line++;
+    }
+  }
+  for (int i = 0; i < 32; i++) {
+    current_flags[i] = flags[harts - 1][i];
+    for (int hart = harts - 2; hart >= 0; hart--) {
+      bprintf(f, "%d ite 1 %d %d %d\n", next_line, picked[hart],
+              flags[hart][i], current_flags[i]);
+      current_flags[i] = next_line;
+      next_line++;
+    }
+  }
+  return next_line;
+}
+
+int btor_write_back(writer *f, int next_line, int harts, int registers[][33],
+                    int flags[][32], int *picked, int *new_registers,
+                    int *new_flags, int hart_registers[][33],
+                    int hart_flags[][32]) {
+  // Only the picked hart takes the values of the command
+  bprintf(f, ";\n; Write back to the picked hart\n");
+  for (int hart = 0; hart < harts; hart++) {
+    for (int i = 0; i < 33; i++) {
+      if (!is_register_state(i)) {
+        continue;
+      }
+      bprintf(f, "%d ite %d %d %d %d\n", next_line, register_state_sort(i),
+              picked[hart], new_registers[i], registers[hart][i]);
+      hart_registers[hart][i] = next_line;
+      next_line++;
+    }
+    for (int i = 0; i < 32; i++) {
+      bprintf(f, "%d ite 1 %d %d %d\n", next_line, picked[hart],
+              new_flags[i], flags[hart][i]);
+      hart_flags[hart][i] = next_line;
+      next_line++;
+    }
+  }
+  return next_line;
+}
+
+int btor_partial_order(writer *f, int next_line, int scheduled, int opcode) {
+  // Commands without loads and stores only change their own hart, so two of
+  // them on different harts commute. Of both orders only the one with the
+  // lower hart first is taken.
+  bprintf(f, ";\n; Partial order reduction\n");
+  int hart_sort = scheduled - 1;
+  bprintf(f, "%d constd 5 3\n", next_line);
+  bprintf(f, "%d eq 1 %d %d\n", next_line + 1, opcode, next_line);
+  bprintf(f, "%d constd 5 35\n", next_line + 2);
+  bprintf(f, "%d eq 1 %d %d\n", next_line + 3, opcode, next_line + 2);
+  bprintf(f, "%d or 1 %d %d\n", next_line + 4, next_line + 1,
+          next_line + 3);
+  bprintf(f, "%d not 1 %d local_command\n", next_line + 5, next_line + 4);
+  int local = next_line + 5;
+  next_line += 6;
+  bprintf(f, "%d state 1 %slast_local\n", next_line, instance_name);
+  bprintf(f, "%d init 1 %d 17\n", next_line + 1, next_line);
+  bprintf(f, "%d next 1 %d %d\n", next_line + 2, next_line, local);
+  int last_local = next_line;
+  next_line += 3;
+  bprintf(f, "%d zero %d\n", next_line, hart_sort);
+  bprintf(f, "%d state %d %slast_hart\n", next_line + 1, hart_sort,
+          instance_name);
+  bprintf(f, "%d init %d %d %d\n", next_line + 2, hart_sort, next_line + 1,
+          next_line);
+  bprintf(f, "%d next %d %d %d\n", next_line + 3, hart_sort, next_line + 1,
+          scheduled);
+  int last_hart = next_line + 1;
+  next_line += 4;
+  bprintf(f, "%d ult 1 %d %d\n", next_line, scheduled, last_hart);
+  bprintf(f, "%d and 1 %d %d\n", next_line + 1, last_local, local);
+  bprintf(f, "%d and 1 %d %d\n", next_line + 2, next_line + 1, next_line);
+  bprintf(f, "%d constraint -%d %scanonical_order\n", next_line + 3,
+          next_line + 2, instance_name);
+  return next_line + 4;
+}
+
+int btor_and_into(writer *f, int next_line, int *result, int check) {
+  // Adds a check that has to hold as well, the first one is taken as it is
+  if (!*result) {
+    *result = check;
+    return next_line;
+  }
+  bprintf(f, "%d and 1 %d %d\n", next_line, *result, check);
+  *result = next_line;
+  return next_line + 1;
+}
+
+int btor_loop_register(writer *f, int next_line, int *registers, int i,
+                       int *values) {
+  // Value of register i before the transition, a register file is read once
+  if (values[i]) {
+    return next_line;
+  }
+  if (!register_array) {
+    values[i] = registers[i];
+    return next_line;
+  }
+  bprintf(f, "%d constd 18 %d\n", next_line, i);
+  bprintf(f, "%d read %d %d %d\n", next_line + 1, register_sort, registers[0],
+          next_line);
+  values[i] = next_line + 1;
+  return next_line + 2;
+}
+
+int btor_loop_stores(writer *f, int next_line, counting_loop *loop,
+                     int *values, int *first_addresses, int memory, int k,
+                     int k_sort, int *new_memory) {
+  // Every store of every iteration below k in their order, so stores that
+  // overlap end as they would. The first iteration is always done.
+  bprintf(f, "%d constd 2 %ld\n", next_line, loop->step);
+  int step = next_line;
+  next_line++;
+  int offsets = next_line; // byte i of a cell is at offsets + i - 1
+  for (int i = 1; i < 8 && cell_bytes == 1; i++) {
+    bprintf(f, "%d constd 2 %d\n", next_line, i);
+    next_line++;
+  }
+  int addresses[MAX_LOOP_BODY];
+  int bytes[MAX_LOOP_BODY]; // first of the value bytes for byte memory
+  for (size_t i = 0; i < loop->n_body; i++) {
+    int width = loop_store_bytes(&loop->body[i]);
+    if (!width) {
+      continue;
+    }
+    bprintf(f, "%d slice 2 %d %d 0\n", next_line, first_addresses[i],
+            memsize - 1);
+    addresses[i] = next_line;
+    bytes[i] = next_line + 1;
+    next_line++;
+    for (int j = 0; j < width && cell_bytes == 1; j++) {
+      bprintf(f, "%d slice 3 %d %d %d\n", next_line,
+              values[loop->body[i].rd], 8 * j + 7, 8 * j);
+      next_line++;
+    }
+  }
+
+  // Later iterations write back what the memory holds unless k is above
+  // them, so the memory stays a single chain of writes
+  int all_bytes = 0;
+  if (cell_bytes > 1) {
+    bprintf(f, "%d ones %d\n", next_line, register_sort);
+    all_bytes = next_line;
+    next_line++;
+  }
+  *new_memory = memory;
+  for (int iteration = 0; iteration < (1 << accelerate_bits) - 1;
+       iteration++) {
+    int enable = 16; // true, the first iteration is always done
+    if (iteration > 0) {
+      bprintf(f, "%d constd %d %d\n", next_line, k_sort, iteration);
+      bprintf(f, "%d ugt 1 %d %d\n", next_line + 1, k, next_line);
+      enable = next_line + 1;
+      next_line += 2;
+    }
+    int mask = 0; // all bytes
+    if (iteration > 0 && cell_bytes > 1) {
+      bprintf(f, "%d ite %d %d %d 8\n", next_line, register_sort, enable,
+              all_bytes); // no byte is written above k
+      mask = next_line;
+      next_line++;
+    }
+    for (size_t i = 0; i < loop->n_body; i++) {
+      int width = loop_store_bytes(&loop->body[i]);
+      if (!width) {
+        continue;
+      }
+      if (iteration > 0) {
+        bprintf(f, "%d add 2 %d %d\n", next_line, addresses[i], step);
+        addresses[i] = next_line;
+        next_line++;
+      }
+      if (cell_bytes > 1) {
+        cell_reads c = {.memory = *new_memory, .address = addresses[i]};
+        int store_mask;
+        next_line = btor_write_span(f, next_line, &c, width,
+                                    spanned_cells(width),
+                                    values[loop->body[i].rd], mask,
+                                    new_memory, &store_mask);
+        continue;
+      }
+      for (int j = 0; j < width; j++) {
+        int address = addresses[i];
+        if (j > 0) {
+          bprintf(f, "%d add 2 %d %d\n", next_line, addresses[i],
+                  offsets + j - 1);
+          address = next_line;
+          next_line++;
+        }
+        if (iteration == 0) {
+          bprintf(f, "%d write %d %d %d %d\n", next_line, memory_sort,
+                  *new_memory, address, bytes[i] + j);
+          *new_memory = next_line;
+          next_line++;
+          continue;
+        }
+        next_line = btor_write_byte(f, next_line, *new_memory, *new_memory,
+                                    address, bytes[i] + j, enable, "",
+                                    new_memory);
+      }
+    }
+  }
+  return next_line;
+}
+
+int btor_loop_jump(writer *f, int next_line, state *s, counting_loop *loop,
+                   int *registers, int *flags, int memory, int counter_loc,
+                   int k, int k_sort, int k_nonzero, int k_register,
+                   int k_counter, int counter_left,
+                   int *new_registers, int *new_flags, int *new_memory,
+                   int *new_counter, int *jump) {
+  bprintf(f, ";\n; Jump over iterations of the loop at %lx\n", loop->head);
+  int values[32] = {0};
+  int checks = k_nonzero; // all have to hold for the jump
+  bprintf(f, "%d constd 2 %ld\n", next_line, loop->head);
+  bprintf(f, "%d eq 1 %d %d loop_head\n", next_line + 1, registers[32],
+          next_line);
+  int head = next_line;
+  next_line = btor_and_into(f, next_line + 2, &checks, next_line + 1);
+
+  // The counter does not pass its limit on the way
+  bprintf(f, "%d constd 6 %ld\n", next_line, loop_commands(loop));
+  bprintf(f, "%d mul 6 %d %d\n", next_line + 1, k_counter, next_line);
+  bprintf(f, "%d ulte 1 %d %d\n", next_line + 2, next_line + 1,
+          counter_left);
+  int commands = next_line + 1;
+  next_line = btor_and_into(f, next_line + 3, &checks, next_line + 2);
+
+  // No iteration leaves the loop, the last one starts below the bound
+  next_line =
+      btor_loop_register(f, next_line, registers, loop->counter, values);
+  next_line = btor_loop_register(f, next_line, registers, loop->bound, values);
+  int counter = values[loop->counter];
+  bprintf(f, "%d %s 1 %d %d\n", next_line, loop->is_unsigned ? "ult" : "slt",
+          counter, values[loop->bound]);
+  bprintf(f, "%d sub %d %d %d\n", next_line + 1, register_sort,
+          values[loop->bound], counter);
+  bprintf(f, "%d dec %d %d\n", next_line + 2, register_sort, next_line + 1);
+  bprintf(f, "%d dec %d %d\n", next_line + 3, register_sort, k_register);
+  bprintf(f, "%d constd %d %ld\n", next_line + 4, register_sort, loop->step);
+  bprintf(f, "%d mul %d %d %d\n", next_line + 5, register_sort,
+          next_line + 3, next_line + 4); // counter of the last iteration
+  bprintf(f, "%d ulte 1 %d %d\n", next_line + 6, next_line + 5,
+          next_line + 2);
+  bprintf(f, "%d and 1 %d %d\n", next_line + 7, next_line, next_line + 6);
+  int k_minus_one = next_line + 3;
+  int step = next_line + 4;
+  int last_distance = next_line + 5;
+  next_line = btor_and_into(f, next_line + 8, &checks, next_line + 7);
+
+  if (!memory_regions || loop->head < code_start || loop->end > code_end) {
+    // Stores before the loop may have changed it
+    for (uint64_t pc = loop->head; pc < loop->end; pc += 4) {
+      bprintf(f, "%d constd 2 %ld\n", next_line, pc);
+      next_line =
+          btor_get_current_command(f, next_line + 1, next_line, memory);
+      bprintf(f, "%d consth 5 %08x\n", next_line, get_word(s, pc));
+      bprintf(f, "%d eq 1 %d %d\n", next_line + 1, next_line - 1, next_line);
+      next_line = btor_and_into(f, next_line + 2, &checks, next_line + 1);
+    }
+  }
+
+  // Stored bytes are one piece of memory apart from the code
+  uint64_t code_low = loop->head;
+  uint64_t code_high = loop->end;
+  if (memory_regions) {
+    code_low = code_start < code_low ? code_start : code_low;
+    code_high = code_end > code_high ? code_end : code_high;
+  }
+  int first_addresses[MAX_LOOP_BODY];
+  bool stores = false;
+  for (size_t i = 0; i < loop->n_body; i++) {
+    int width = loop_store_bytes(&loop->body[i]);
+    if (!width) {
+      continue;
+    }
+    stores = true;
+    bprintf(f, "%d constd %d %ld\n", next_line, register_sort,
+            loop->body[i].immediate);
+    bprintf(f, "%d add %d %d %d\n", next_line + 1, register_sort, counter,
+            next_line);
+    bprintf(f, "%d constd %d %d\n", next_line + 2, register_sort, width - 1);
+    bprintf(f, "%d add %d %d %d\n", next_line + 3, register_sort,
+            last_distance, next_line + 2);
+    bprintf(f, "%d add %d %d %d\n", next_line + 4, register_sort,
+            next_line + 1, next_line + 3); // last stored byte
+    bprintf(f, "%d ulte 1 %d %d\n", next_line + 5, next_line + 1,
+            next_line + 4);
+    bprintf(f, "%d constd %d %ld\n", next_line + 6, register_sort, code_low);
+    bprintf(f, "%d constd %d %ld\n", next_line + 7, register_sort,
+            code_high);
+    bprintf(f, "%d ult 1 %d %d\n", next_line + 8, next_line + 4,
+            next_line + 6);
+    bprintf(f, "%d ugte 1 %d %d\n", next_line + 9, next_line + 1,
+            next_line + 7);
+    bprintf(f, "%d or 1 %d %d\n", next_line + 10, next_line + 8,
+            next_line + 9);
+    bprintf(f, "%d and 1 %d %d\n", next_line + 11, next_line + 5,
+            next_line + 10);
+    first_addresses[i] = next_line + 1;
+    int last = next_line + 4;
+    next_line = btor_and_into(f, next_line + 12, &checks, next_line + 11);
+    if (memsize < xlen) { // the addresses do not wrap around
+      bprintf(f, "%d constd %d %ld\n", next_line, register_sort,
+              pow_memsize);
+      bprintf(f, "%d ult 1 %d %d\n", next_line + 1, last, next_line);
+      next_line = btor_and_into(f, next_line + 2, &checks, next_line + 1);
+    }
+    next_line =
+        btor_loop_register(f, next_line, registers, loop->body[i].rd, values);
+  }
+  *jump = checks;
+
+  // Registers after k iterations, the counter is added k(k-1)/2 times its step
+  int sums[32] = {0};
+  bprintf(f, "%d mul %d %d %d\n", next_line, register_sort, k_register, step);
+  bprintf(f, "%d add %d %d %d\n", next_line + 1, register_sort, counter,
+          next_line);
+  sums[loop->counter] = next_line + 1;
+  next_line += 2;
+  int triangle = 0;
+  for (size_t i = 0; i < loop->n_body; i++) {
+    loop_update *update = &loop->body[i];
+    if (loop_store_bytes(update)) {
+      continue;
+    }
+    next_line =
+        btor_loop_register(f, next_line, registers, update->rd, values);
+    int sum = sums[update->rd] ? sums[update->rd] : values[update->rd];
+    if (update->command == CMD_ADDI) {
+      bprintf(f, "%d constd %d %ld\n", next_line, register_sort,
+              update->immediate);
+      bprintf(f, "%d mul %d %d %d\n", next_line + 1, register_sort,
+              k_register, next_line);
+      bprintf(f, "%d add %d %d %d\n", next_line + 2, register_sort, sum,
+              next_line + 1);
+      sums[update->rd] = next_line + 2;
+      next_line += 3;
+      continue;
+    }
+    next_line =
+        btor_loop_register(f, next_line, registers, update->rs, values);
+    bprintf(f, "%d mul %d %d %d\n", next_line, register_sort, k_register,
+            values[update->rs]);
+    bprintf(f, "%d add %d %d %d\n", next_line + 1, register_sort, sum,
+            next_line);
+    sums[update->rd] = next_line + 1;
+    next_line += 2;
+    if (update->rs != loop->counter) {
+      continue;
+    }
+    if (!triangle) {
+      bprintf(f, "%d mul %d %d %d\n", next_line, register_sort, k_register,
+              k_minus_one);
+      bprintf(f, "%d one %d\n", next_line + 1, register_sort);
+      bprintf(f, "%d srl %d %d %d\n", next_line + 2, register_sort, next_line,
+              next_line + 1);
+      bprintf(f, "%d mul %d %d %d\n", next_line + 3, register_sort,
+              next_line + 2, step);
+      triangle = next_line + 3;
+      next_line += 4;
+    }
+    bprintf(f, "%d add %d %d %d\n", next_line, register_sort,
+            sums[update->rd], triangle);
+    sums[update->rd] = next_line;
+    next_line++;
+  }
+
+  // With several commands per transition the others are undone as well
+  if (register_array) {
+    int file = registers[0];
+    for (int i = 1; i < 32; i++) {
+      if (sums[i]) {
+        bprintf(f, "%d constd 18 %d\n", next_line, i);
+        bprintf(f, "%d write %d %d %d %d\n", next_line + 1,
+                register_file_sort, file, next_line, sums[i]);
+        file = next_line + 1;
+        next_line += 2;
+      }
+    }
+    bprintf(f, "%d ite %d %d %d %d\n", next_line, register_file_sort, *jump,
+            file, new_registers[0]);
+    new_registers[0] = next_line;
+    next_line++;
+  }
+  for (int i = 1; i < 32; i++) {
+    if (sums[i] && !register_array) {
+      bprintf(f, "%d ite %d %d %d %d\n", next_line, register_sort, *jump,
+              sums[i], new_registers[i]);
+      new_registers[i] = next_line;
+      next_line++;
+    } else if (big_step > 1 && !register_array) {
+      bprintf(f, "%d ite %d %d %d %d\n", next_line, register_sort, *jump,
+              registers[i], new_registers[i]);
+      new_registers[i] = next_line;
+      next_line++;
+    }
+    if (sums[i]) {
+      bprintf(f, "%d or 1 %d %d\n", next_line, *jump, new_flags[i]);
+      new_flags[i] = next_line;
+      next_line++;
+    } else if (big_step > 1) {
+      bprintf(f, "%d ite 1 %d %d %d\n", next_line, *jump, flags[i],
+              new_flags[i]);
+      new_flags[i] = next_line;
+      next_line++;
+    }
+  }
+  bprintf(f, "%d ite 2 %d %d %d\n", next_line, *jump, head,
+          new_registers[32]);
+  new_registers[32] = next_line;
+  next_line++;
+
+  int jumped_memory = memory;
+  if (stores) {
+    next_line = btor_loop_stores(f, next_line, loop, values, first_addresses,
+                                 memory, k, k_sort, &jumped_memory);
+  }
+  if (stores || big_step > 1) {
+    bprintf(f, "%d ite %d %d %d %d\n", next_line, memory_sort, *jump,
+            jumped_memory, *new_memory);
+    *new_memory = next_line;
+    next_line++;
+  }
+  bprintf(f, "%d add 6 %d %d\n", next_line, counter_loc, commands);
+  bprintf(f, "%d ite 6 %d %d %d\n", next_line + 1, *jump, next_line,
+          *new_counter);
+  *new_counter = next_line + 1;
+  return next_line + 2;
+}
+
+int btor_loop_jumps(writer *f, int next_line, state *s, int *registers,
+                    int *flags, int memory, int counter_loc, int iterations,
+                    int *new_registers, int *new_flags, int *new_memory,
+                    int *jumped) {
+  // An input k other than zero does k iterations of the loop at the pc
+  bprintf(f, ";\n; Loop acceleration\n");
+  bprintf(f, "%d sort bitvec %d Iterations\n", next_line, accelerate_bits);
+  bprintf(f, "%d input %d %sjump_iterations\n", next_line + 1, next_line,
+          instance_name);
+  bprintf(f, "%d zero %d\n", next_line + 2, next_line);
+  bprintf(f, "%d neq 1 %d %d\n", next_line + 3, next_line + 1,
+          next_line + 2);
+  bprintf(f, "%d uext %d %d %d\n", next_line + 4, register_sort,
+          next_line + 1, xlen - accelerate_bits);
+  bprintf(f, "%d uext 6 %d %d\n", next_line + 5, next_line + 1,
+          64 - accelerate_bits);
+  bprintf(f, "%d constd 6 %d\n", next_line + 6, iterations);
+  bprintf(f, "%d sub 6 %d %d\n", next_line + 7, next_line + 6, counter_loc);
+  bprintf(f, "%d ulte 1 %d %d\n", next_line + 8, counter_loc, next_line + 6);
+  bprintf(f, "%d zero 6\n", next_line + 9);
+  bprintf(f, "%d ite 6 %d %d %d\n", next_line + 10, next_line + 8,
+          next_line + 7, next_line + 9); // commands before the limit
+  int k_sort = next_line;
+  int k = next_line + 1;
+  int k_nonzero = next_line + 3;
+  int k_register = next_line + 4;
+  int k_counter = next_line + 5;
+  int counter_left = next_line + 10;
+  next_line += 11;
+
+  int new_counter = counter_loc + 2; // counter plus the commands of a step
+  *jumped = 0;
+  for (size_t i = 0; i < n_loops; i++) {
+    int jump;
+    next_line = btor_loop_jump(f, next_line, s, &loops[i], registers, flags,
+                               memory, counter_loc, k, k_sort, k_nonzero,
+                               k_register, k_counter, counter_left,
+                               new_registers, new_flags, new_memory,
+                               &new_counter, &jump);
+    if (*jumped) {
+      bprintf(f, "%d or 1 %d %d\n", next_line, *jumped, jump);
+      jump = next_line;
+      next_line++;
+    }
+    *jumped = jump;
+  }
+  bprintf(f, "%d next 6 %d %d\n", next_line, counter_loc, new_counter);
+  return next_line + 1;
+}
+
+int btor_transition(writer *f, int next_line, state *s, int harts,
+                    int state_registers[][33], int state_flags[][32],
+                    int memory, int code_memory, int counter_loc,
+                    int iterations) {
+  // Steps, next states and bads of an instance. Every step starts on the
+  // values the previous one computed.
+  int step_registers[2][33];
+  int step_flags[2][32];
+  memcpy(step_registers[0], state_registers[0], sizeof(step_registers[0]));
+  memcpy(step_flags[0], state_flags[0], sizeof(step_flags[0]));
+  int scheduled = 0;
+  int picked[harts];
+  if (harts > 1) {
+    next_line = btor_scheduler(f, next_line, harts, state_registers,
+                               state_flags, &scheduled, picked,
+                               step_registers[0], step_flags[0]);
+  }
+  int step_memory = memory;
+  int bad_locs[big_step][BAD_COUNT];
+  int step_counter = counter_loc;
+  int opcode;
+  for (int step = 0; step < big_step; step++) {
+    if (big_step > 1) {
+      bprintf(f, ";\n; Step %d of the transition\n", step);
+    }
+    if (step > 0) { // counter as if every step was a transition
+      bprintf(f, "%d constd 6 %d\n", next_line, step);
+      bprintf(f, "%d add 6 %d %d\n", next_line + 1, counter_loc, next_line);
+      step_counter = next_line + 1;
+      next_line += 2;
+    }
+    int *current_registers = step_registers[step % 2];
+    int *current_flags = step_flags[step % 2];
+    next_line =
+        btor_step(f, next_line, current_registers, current_flags, step_memory,
+                  code_memory, step_counter, iterations,
+                  step_registers[(step + 1) % 2], step_flags[(step + 1) % 2],
+                  &step_memory, bad_locs[step], &opcode);
+  }
+
+  int new_registers[harts][33];
+  int new_flags[harts][32];
+  memcpy(new_registers[0], step_registers[big_step % 2],
+         sizeof(new_registers[0]));
+  memcpy(new_flags[0], step_flags[big_step % 2], sizeof(new_flags[0]));
+  if (harts > 1) {
+    next_line = btor_write_back(f, next_line, harts, state_registers,
+                                state_flags, picked, step_registers[1],
+                                step_flags[1], new_registers, new_flags);
+  }
+  int jumped = 0;
+  if (accelerate_bits) {
+    next_line = btor_loop_jumps(f, next_line, s, state_registers[0],
+                                state_flags[0], memory, counter_loc,
+                                iterations, new_registers[0], new_flags[0],
+                                &step_memory, &jumped);
+  }
+  next_line = btor_next_states(f, next_line, harts, state_registers,
+                               state_flags, memory, new_registers, new_flags,
+                               step_memory);
+
+  next_line = btor_bads(f, next_line, bad_locs, big_step, jumped);
+
+  if (harts > 1) {
+    next_line = btor_partial_order(f, next_line, scheduled, opcode);
+  }
+  return next_line;
+}
+
+bool has_fixed_transition(void) {
+  return n_harts <= 1 && !scalar_cells && !accelerate_bits;
+}
+
+void transition_key(char *key, size_t size, int counter_loc, int iterations,
+                    int code_memory) {
+  // Everything the transition depends on, but the lines of the state
+  char commands[COMMAND_COUNT + 1];
+  for (int i = 0; i < COMMAND_COUNT; i++) {
+    commands[i] = is_command_used(i) ? '1' : '0';
+  }
+  commands[COMMAND_COUNT] = '\0';
+  char props[BAD_COUNT + 1];
+  for (int i = 0; i < BAD_COUNT; i++) {
+    props[i] = selected_props[i] ? '1' : '0';
+  }
+  props[BAD_COUNT] = '\0';
+  snprintf(key, size,
+           "a%d/%d h%d/%d/%lx w%d/%d r%d/%d/%d/%d c%d/%lx/%lx/%d k%d "
+           "m%d/%d/%d/%d/%d n%d l%d/%d i%d p%s u%s",
+           memsize, address_range_check, halt_check, halt_at_exit,
+           exit_address % pow_memsize, shared_writeback, store_select,
+           register_array, register_file_sort, register_sort, xlen,
+           memory_regions, code_start, code_end, code_memory != 0, big_step,
+           cell_bytes, index_sort, cell_sort, memory_sort, memory_init,
+           iterations, counter_loc, shared_lines, instance > 0, props,
+           commands);
+}
+
+char *record_transition_at(int first_line, int first_input, int counter_loc,
+                           int iterations, int code_memory, size_t *length,
+                           int *n_lines) {
+  // The transition on the input ids from first_input
+  int registers[1][33];
+  int flags[1][32];
+  for (int i = 0; i < 33; i++) {
+    registers[0][i] = first_input + i;
+  }
+  for (int i = 0; i < 32; i++) {
+    flags[0][i] = first_input + 33 + i;
+  }
+  int memory = first_input + 65;
+  if (code_memory) {
+    code_memory = first_input + 66;
+  }
+  writer *w = open_memory_writer();
+  if (!w) {
+    return NULL;
+  }
+  int end = btor_transition(w, first_line, NULL, 1, registers, flags, memory,
+                            code_memory, counter_loc, iterations);
+  *n_lines = end - first_line;
+  return take_writer_buffer(w, length);
+}
+
+model_template *record_transition(const char *key, int counter_loc,
+                                  int iterations, int code_memory) {
+  // Recorded twice on other ids, with the mark for the instance name
+  char name[sizeof(instance_name)];
+  strcpy(name, instance_name);
+  strcpy(instance_name, TEMPLATE_NAME_MARK);
+  size_t a_length;
+  size_t b_length;
+  int a_lines;
+  int b_lines;
+  char *a = record_transition_at(TEMPLATE_LINES_A, TEMPLATE_INPUTS_A,
+                                 counter_loc, iterations, code_memory,
+                                 &a_length, &a_lines);
+  char *b = record_transition_at(TEMPLATE_LINES_B, TEMPLATE_INPUTS_B,
+                                 counter_loc, iterations, code_memory,
+                                 &b_length, &b_lines);
+  strcpy(instance_name, name);
+  if (!a || !b || a_lines != b_lines) {
+    free(a);
+    free(b);
+    return NULL;
+  }
+  return compile_template(key, a, a_length, b, b_length, a_lines);
+}
+
+int btor_template_transition(writer *f, int next_line, int *registers,
+                             int *flags, int memory, int code_memory,
+                             int counter_loc, int iterations) {
+  // The transition written from the template, which is recorded again when
+  // the options differ from the last one
+  char key[256 + COMMAND_COUNT + BAD_COUNT];
+  transition_key(key, sizeof(key), counter_loc, iterations, code_memory);
+  model_template **kept = &transition_templates[instance > 0];
+  if (!*kept || strcmp((*kept)->key, key)) {
+    if (*kept) {
+      kill_template(*kept);
+    }
+    *kept = record_transition(key, counter_loc, iterations, code_memory);
+    if (!*kept) {
+      fprintf(stderr, "Transition could not be recorded, it is emitted "
+                      "directly.\n");
+    }
+  }
+  if (!*kept) {
+    int state_registers[1][33];
+    int state_flags[1][32];
+    memcpy(state_registers[0], registers, sizeof(state_registers[0]));
+    memcpy(state_flags[0], flags, sizeof(state_flags[0]));
+    return btor_transition(f, next_line, NULL, 1, state_registers,
+                           state_flags, memory, code_memory, counter_loc,
+                           iterations);
+  }
+  int inputs[67];
+  memcpy(inputs, registers, 33 * sizeof(int));
+  memcpy(inputs + 33, flags, 32 * sizeof(int));
+  inputs[65] = memory;
+  inputs[66] = code_memory;
+  return write_template(f, *kept, next_line, inputs, instance_name);
+}
+
+int btor_instance(writer *f, int next_line, state *s, int counter_loc,
+                  int iterations, int *code_memory) {
+  // Registers, memory, transition and bads of one state
+  int harts = n_harts > 1 ? n_harts : 1;
+  int state_registers[harts][33]; // with a register file, [0] is the array
+  int state_flags[harts][32];
+  for (int hart = 0; hart < harts; hart++) {
+    state *registers = get_hart(s, hart);
+    snprintf(register_name, sizeof(register_name), "%s", instance_name);
+    if (hart > 0) {
+      snprintf(register_name, sizeof(register_name), "%sh%d.",
+               instance_name, hart);
+      bprintf(f, ";\n; Hart %d\n", hart);
+    }
+    int reg_const_loc = next_line;
+    next_line = btor_register_consts(f, next_line, registers);
+    next_line = btor_registers(f, next_line, reg_const_loc, registers,
+                               state_registers[hart]);
+
+    int reg_init_flag_loc = next_line;
+    next_line =
+        btor_register_initialisation_flags(f, next_line, registers);
+    next_line =
+        btor_symbolic_registers(f, next_line, reg_const_loc, counter_loc,
+                                registers, state_registers[hart]);
+    for (int i = 0; i < 32; i++) {
+      state_flags[hart][i] = reg_init_flag_loc + i;
+    }
+  }
+
+  int memory;
+  if (scalar_cells) {
+    next_line = btor_scalar_memory(f, next_line, s, counter_loc, &memory);
+  } else {
+    next_line =
+        btor_memory(f, next_line, s, counter_loc, &memory, code_memory);
+  }
+
+  bool reused = transitions_written >= TEMPLATE_MIN_INSTANCES ||
+                (n_instances >= TEMPLATE_MIN_INSTANCES && instance > 0);
+  transitions_written++;
+  if (has_fixed_transition() && reused) {
+    next_line = btor_template_transition(f, next_line, state_registers[0],
+                                         state_flags[0], memory, *code_memory,
+                                         counter_loc, iterations);
+  } else {
+    next_line = btor_transition(f, next_line, s, harts, state_registers,
+                                state_flags, memory, *code_memory, counter_loc,
+                                iterations);
+  }
+  if (pc_constraint && n_reachable_pcs[instance]) {
+    next_line = btor_pc_constraint(f, next_line, state_registers[0][32],
+                                   reachable_pcs[instance],
+                                   n_reachable_pcs[instance]);
+  }
+  return next_line;
+}
+
+void relational_btor(writer *f, state **states, int iterations) {
+  int next_line = btor_constants(f);
+
+  int counter_loc =
+      next_line + 2; // there are two needed constants before the state
+  next_line = btor_counter(f, next_line);
+  shared_lines = next_line;
+
+  int code_memory = 0; // only exists with memory regions
+  for (instance = 0; instance < n_instances; instance++) {
+    if (n_instances > 1) {
+      snprintf(instance_name, sizeof(instance_name), "i%d.", instance);
+      bprintf(f, ";\n; Instance %d\n", instance);
+    }
+    next_line = btor_instance(f, next_line, states[instance], counter_loc,
+                              iterations, &code_memory);
+  }
+}
+
+void report_dead_code(state *s, uint64_t *pcs, size_t n_pcs) {
+  // Lists the commands in initialised memory that no run can reach
+  uint64_t *addresses = get_initialised_adresses(s->memory);
+  size_t dead = 0;
+  size_t k = 0;
+  uint64_t last_word = 0;
+  bool first = true;
+  fprintf(stderr, "Unreachable commands:\n");
+  for (size_t i = 1; i <= addresses[0]; i++) {
+    uint64_t word = addresses[i] - ((addresses[i] - s->pc) % 4);
+    if ((!first && word == last_word) || word >= pow_memsize) {
+      continue;
+    }
+    first = false;
+    last_word = word;
+    while (k < n_pcs && pcs[k] < word) {
+      k++;
+    }
+    uint32_t command = 0;
+    for (int j = 3; j >= 0; j--) {
+      command = command << 8;
+      command += get_memory_cell_content(s->memory, word + j);
+    }
+    if ((k < n_pcs && pcs[k] == word) ||
+        decode_command(command) == CMD_UNKNOWN) {
+      continue; // reached, or data
+    }
+    char text[64];
+    disassemble_command(command, text, sizeof(text));
+    fprintf(stderr, "  %lx: %08x %s\n", word, command, text);
+    dead++;
+  }
+  fprintf(stderr, "%ld commands are unreachable, %ld pcs are reachable\n",
+          dead, n_pcs);
+  free(addresses);
+}
+
+int auto_address_width(state *s) {
+  // Smallest width holding every initialised byte, the pc and each cell the
+  // program can reach. If the analysis can not bound them, the width is at
+  // least the default one. Accesses beyond are left to address_out_of_range.
+  uint64_t highest = s->pc + 3;
+  uint64_t *addresses = get_initialised_adresses(s->memory);
+  for (size_t i = 1; i <= addresses[0]; i++) {
+    highest = addresses[i] > highest ? addresses[i] : highest;
+  }
+  free(addresses);
+  for (size_t i = 0; i < s->n_symbolic_memory; i++) {
+    if (s->symbolic_memory[i].end > highest) {
+      highest = s->symbolic_memory[i].end;
+    }
+  }
+  uint64_t cells[AUTO_WIDTH_CELLS];
+  uint8_t kinds[AUTO_WIDTH_CELLS];
+  size_t n_cells =
+      find_memory_footprint(s, 0, xlen, cells, kinds, AUTO_WIDTH_CELLS);
+  if (n_cells && cells[n_cells - 1] > highest) {
+    highest = cells[n_cells - 1];
+  }
+  int width = n_cells ? cell_shift + 2 : BTOR_MEMORY_SIZE; // one command
+  while (width < xlen && width < 63 && highest >> width) {
+    width++;
+  }
+  return width;
+}
+
+bool has_code_of(state *s, state *first) {
+  // Same code region as the first instance, with the same commands in it
+  uint64_t start, end;
+  if (!find_code_region(s, pow_memsize, &start, &end) || start != code_start ||
+      end != code_end) {
+    return false;
+  }
+  for (uint64_t address = start; address < end; address++) {
+    if (get_memory_cell_content(s->memory, address) !=
+        get_memory_cell_content(first->memory, address)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+const char *bad_step(state *s, concrete_step *step) {
+  // Why a bad of the model could hold before the step, NULL if none can
+  uint64_t next_pc = step->next_pc % pow_memsize;
+  if (!is_command_used(step->command)) {
+    return "the command is not in the ISA subset";
+  }
+  if ((step->command == CMD_JAL || step->command == CMD_JALR) &&
+      (next_pc & 3)) {
+    return "the jump is misaligned";
+  }
+  bool at_exit = halt_at_exit && s->pc == exit_address % pow_memsize;
+  if (halt_check && (next_pc == s->pc || at_exit)) {
+    return "the program halts";
+  }
+  uint64_t last = (step->address + step->bytes - 1) &
+                  (xlen == 32 ? 0xffffffff : UINT64_MAX);
+  bool access_out = step->address >= pow_memsize || last >= pow_memsize;
+  if (address_range_check &&
+      (step->next_pc >= pow_memsize || (step->bytes && access_out))) {
+    return "an address is out of range";
+  }
+  for (int i = 0; memory_regions && step->is_store && i < step->bytes; i++) {
+    uint64_t address = (step->address + i) % pow_memsize;
+    if (address >= code_start && address < code_end) {
+      return "the store is to the code";
+    }
+  }
+  return NULL;
+}
+
+uint64_t fast_forward(state *s, uint64_t max_steps) {
+  // Executes the state until max_steps commands are done, the target pc is
+  // reached or the next command could be bad or needs symbolic values.
+  // Returns the commands executed.
+  uint64_t steps = 0;
+  set_pc(s, s->pc % pow_memsize);
+  while (steps < max_steps &&
+         !(fast_forward_to_pc &&
+           s->pc == fast_forward_target % pow_memsize)) {
+    concrete_step step;
+    const char *stop = NULL;
+    if (!find_step(s, pow_memsize, xlen, &step)) {
+      stop = step.command == CMD_UNKNOWN ? "the command is unknown"
+                                         : "a value is symbolic";
+    } else {
+      stop = bad_step(s, &step);
+    }
+    if (stop) {
+      fprintf(stderr,
+              "Fast-forward stopped after %lu commands at pc %lx, %s.\n",
+              steps, s->pc, stop);
+      break;
+    }
+    // Jumping to itself without changing rd, every further step is the same
+    bool self_loop = step.next_pc % pow_memsize == s->pc &&
+                     (!step.rd || (is_register_initialised(s, step.rd) &&
+                                   get_register(s, step.rd) == step.value));
+    apply_step(s, pow_memsize, xlen, &step);
+    steps++;
+    if (self_loop) {
+      steps = max_steps;
+    }
+  }
+  return steps;
+}
+
+state *copy_state(state *s) {
+  // Through the text of the state, echo_state writes all of it
+  char *text = NULL;
+  size_t length = 0;
+  FILE *echo = open_memstream(&text, &length);
+  if (!echo) {
+    return NULL;
+  }
+  echo_state(s, echo);
+  fclose(echo);
+  state *copy = create_new_state();
+  if (copy && !load_state_buffer(text, length, copy)) {
+    kill_state(copy);
+    copy = NULL;
+  }
+  free(text);
+  return copy;
+}
+
+void reset_model_options(void) {
+  // The defaults above, options of an earlier model do not carry over
+  memsize = BTOR_MEMORY_SIZE;
+  pow_memsize = 1 << BTOR_MEMORY_SIZE;
+  address_range_check = false;
+  halt_check = false;
+  halt_at_exit = false;
+  exit_address = 0;
+  isa_subset_auto = false;
+  memset(used_commands, 0, sizeof(used_commands));
+  shared_writeback = true;
+  memory_regions = false;
+  store_select = false;
+  code_start = 0;
+  code_end = 0;
+  big_step = 1;
+  register_array = false;
+  register_file_sort = 0;
+  xlen = 0;
+  register_sort = 6;
+  cell_bytes = 1;
+  cell_shift = 0;
+  index_sort = 2;
+  cell_sort = 3;
+  memory_sort = 7;
+  span_sort = 0;
+  max_scalar_cells = 0;
+  scalar_cells = 0;
+  scalar_stored = 0;
+  scalar_states = 0;
+  scalar_address_consts = 0;
+  pc_constraint = false;
+  dead_code_report = false;
+  n_instances = 1;
+  instance = 0;
+  instance_name[0] = '\0';
+  n_harts = 0;
+  register_name[0] = '\0';
+  accelerate_bits = 0;
+  n_loops = 0;
+  fast_forward_steps = 0;
+  fast_forward_to_pc = false;
+  fast_forward_target = 0;
+  fast_forward_file = NULL;
+  counter_start = 0;
+  model_iterations = 1;
+  cache_dir = NULL;
+  cache_bytes = (uint64_t)MODEL_CACHE_SIZE << 20;
+  shared_lines = 0;
+  memory_init = INIT_CHAIN;
+  for (int i = 0; i < BAD_COUNT; i++) {
+    selected_props[i] = true;
+  }
+  slice_props = false;
+}
+
+void add_options_to_cache_key(cache_key *k) {
+  // The parsed values in a fixed order, so the order of the options and
+  // repeated ones do not change the key
+  uint64_t values[] = {memsize, address_range_check, halt_check, halt_at_exit,
+                       exit_address, isa_subset_auto, shared_writeback,
+                       memory_regions, store_select, big_step, register_array,
+                       xlen, cell_bytes, max_scalar_cells, pc_constraint,
+                       n_harts, accelerate_bits, fast_forward_steps,
+                       fast_forward_to_pc, fast_forward_target,
+                       model_iterations, memory_init, slice_props};
+  add_to_cache_key(k, values, sizeof(values));
+  add_to_cache_key(k, selected_props, sizeof(selected_props));
+}
+
+int set_model_options(int argc, char *argv[], char **target,
+                      bool *to_stdout) {
+  reset_model_options();
+  int opt;
+  struct option long_options[] = {
+      {"isa-subset", required_argument, NULL, OPT_ISA_SUBSET},
+      {"memory-regions", no_argument, NULL, OPT_MEMORY_REGIONS},
+      {"writeback", required_argument, NULL, OPT_WRITEBACK},
+      {"memory-init", required_argument, NULL, OPT_MEMORY_INIT},
+      {"memory-cells", required_argument, NULL, OPT_MEMORY_CELLS},
+      {"store", required_argument, NULL, OPT_STORE},
+      {"registers", required_argument, NULL, OPT_REGISTERS},
+      {"xlen", required_argument, NULL, OPT_XLEN},
+      {"scalar-memory", required_argument, NULL, OPT_SCALAR_MEMORY},
+      {"pc-constraint", no_argument, NULL, OPT_PC_CONSTRAINT},
+      {"dead-code", no_argument, NULL, OPT_DEAD_CODE},
+      {"halt", optional_argument, NULL, OPT_HALT},
+      {"props", required_argument, NULL, OPT_PROPS},
+      {"harts", required_argument, NULL, OPT_HARTS},
+      {"accelerate", required_argument, NULL, OPT_ACCELERATE},
+      {"fast-forward", required_argument, NULL, OPT_FAST_FORWARD},
+      {"fast-forward-to", required_argument, NULL, OPT_FAST_FORWARD_TO},
+      {"fast-forward-state", required_argument, NULL, OPT_FAST_FORWARD_STATE},
+      {"cache-dir", required_argument, NULL, OPT_CACHE_DIR},
+      {"cache-size", required_argument, NULL, OPT_CACHE_SIZE},
+      {NULL, 0, NULL, 0}};
+
+  start_cache_key(&model_key, argv[0]);
+  optind = 0; // every call parses from the start
+  while ((opt = getopt_long(argc, argv, "a:o:n:pk:", long_options, NULL)) !=
+         -1) {
+    switch (opt) {
+    case 'o': // output file
+      if (!target) {
+        break;
+      }
+      *target = realloc(*target, strlen(optarg) + 1); // +1 for null terminator
+      if (!*target) {
+        fprintf(stderr, "Memory allocation failed for target file name.\n");
+        return -1;
+      }
+      strcpy(*target, optarg);
+      break;
+    case 'n': // iterations
+      model_iterations = atoi(optarg);
+      break;
+    case 'a': // address width of the memory
+      if (!strcmp(optarg, "auto")) {
+        address_range_check = true; // width is chosen after loading
+        break;
+      }
+      unsigned int a = atoi(optarg);
+      if (a > 0) {
+        memsize = a;
+        pow_memsize = (uint64_t)1 << (memsize);
+      } else {
+        fprintf(stderr,
+                "Address space must be a positive integer or 'auto'.\n");
+        return -1;
+      }
+      break;
+    case 'p': // print
+      if (to_stdout) {
+        *to_stdout = true;
+      }
+      break;
+    case 'k': // commands per transition
+      big_step = atoi(optarg);
+      if (big_step < 1) {
+        fprintf(stderr, "Big step must be a positive integer.\n");
+        return -1;
+      }
+      break;
+    case OPT_WRITEBACK: // how registers select their next value
+      if (!strcmp(optarg, "shared")) {
+        shared_writeback = true;
+      } else if (!strcmp(optarg, "chain")) {
+        shared_writeback = false; // one ite chain per register, as before
+      } else {
+        fprintf(stderr, "Writeback must be 'shared' or 'chain'.\n");
+        return -1;
+      }
+      break;
+    case OPT_REGISTERS: // how the registers are stored
+      if (!strcmp(optarg, "states")) {
+        register_array = false;
+      } else if (!strcmp(optarg, "array")) {
+        register_array = true;
+      } else {
+        fprintf(stderr, "Registers must be 'states' or 'array'.\n");
+        return -1;
+      }
+      break;
+    case OPT_XLEN: // register width
+      xlen = atoi(optarg);
+      if (xlen != 32 && xlen != 64) {
+        fprintf(stderr, "Xlen must be 32 or 64.\n");
+        return -1;
+      }
+      break;
+    case OPT_SCALAR_MEMORY: // most cells kept as single states
+      if (atoi(optarg) < 0) {
+        fprintf(stderr, "Scalar memory cells must not be negative.\n");
+        return -1;
+      }
+      max_scalar_cells = atoi(optarg);
+      break;
+    case OPT_PC_CONSTRAINT: // pc only takes reachable values
+      pc_constraint = true;
+      break;
+    case OPT_DEAD_CODE: // list unreachable commands
+      dead_code_report = true;
+      break;
+    case OPT_HALT: // halting is bad, optionally at an exit address
+      halt_check = true;
+      if (optarg) {
+        char *end;
+        exit_address = strtoull(optarg, &end, 0);
+        if (*end || !*optarg) {
+          fprintf(stderr, "Exit address must be a number.\n");
+          return -1;
+        }
+        halt_at_exit = true;
+      }
+      break;
+    case OPT_PROPS: // bad properties to emit, comma separated
+      slice_props = true;
+      for (int kind = 0; kind < BAD_COUNT; kind++) {
+        selected_props[kind] = false;
+      }
+      // A copy is split, the options can be given again in the next call
+      char *props = strdup(optarg);
+      for (char *name = strtok(props, ","); name; name = strtok(NULL, ",")) {
+        int kind = 0;
+        while (kind < BAD_COUNT && strcmp(name, prop_names[kind])) {
+          kind++;
+        }
+        if (kind == BAD_COUNT) {
+          fprintf(stderr,
+                  "Unknown property '%s', expected counter, opcode, "
+                  "command, misaligned, store_to_code, out_of_range or "
+                  "halted.\n",
+                  name);
+          free(props);
+          return -1;
+        }
+        selected_props[kind] = true;
+      }
+      free(props);
+      break;
+    case OPT_HARTS: // harts sharing the memory
+      n_harts = atoi(optarg);
+      if (n_harts < 1) {
+        fprintf(stderr, "Harts must be a positive integer.\n");
+        return -1;
+      }
+      break;
+    case OPT_ACCELERATE: // bits of the iterations a counting loop can skip
+      accelerate_bits = atoi(optarg);
+      if (accelerate_bits < 1 || accelerate_bits > 16) {
+        fprintf(stderr, "Accelerate takes 1 to 16 bits.\n");
+        return -1;
+      }
+      break;
+    case OPT_FAST_FORWARD: { // commands executed before the model
+      char *end;
+      fast_forward_steps = strtoull(optarg, &end, 0);
+      if (*end || !*optarg || optarg[0] == '-') {
+        fprintf(stderr, "Fast-forward must be a number of commands.\n");
+        return -1;
+      }
+      break;
+    }
+    case OPT_FAST_FORWARD_TO: { // pc the concrete run stops at
+      char *end;
+      fast_forward_target = strtoull(optarg, &end, 0);
+      if (*end || !*optarg) {
+        fprintf(stderr, "Fast-forward target must be a number.\n");
+        return -1;
+      }
+      fast_forward_to_pc = true;
+      break;
+    }
+    case OPT_FAST_FORWARD_STATE: // where the concrete run ends
+      fast_forward_file = optarg;
+      break;
+    case OPT_CACHE_DIR: // models of earlier runs
+      cache_dir = optarg;
+      break;
+    case OPT_CACHE_SIZE: { // MiB the cache keeps
+      char *end;
+      cache_bytes = strtoull(optarg, &end, 0) << 20;
+      if (*end || !*optarg) {
+        fprintf(stderr, "Cache size must be a number of MiB.\n");
+        return -1;
+      }
+      break;
+    }
+    case OPT_STORE: // how stores change the memory
+      if (!strcmp(optarg, "enable")) {
+        store_select = false;
+      } else if (!strcmp(optarg, "select")) {
+        store_select = true; // one chain per width and ite, as before
+      } else {
+        fprintf(stderr, "Store must be 'enable' or 'select'.\n");
+        return -1;
+      }
+      break;
+    case OPT_MEMORY_CELLS: // bits per memory cell
+      if (!strcmp(optarg, "8")) {
+        cell_bytes = 1;
+        cell_shift = 0;
+      } else if (!strcmp(optarg, "32")) {
+        cell_bytes = 4;
+        cell_shift = 2;
+      } else if (!strcmp(optarg, "64")) {
+        cell_bytes = 8;
+        cell_shift = 3;
+      } else {
+        fprintf(stderr, "Memory cells must be 8, 32 or 64 bit.\n");
+        return -1;
+      }
+      break;
+    case OPT_MEMORY_INIT: // how the initial memory is encoded
+      if (!strcmp(optarg, "chain")) {
+        memory_init = INIT_CHAIN;
+      } else if (!strcmp(optarg, "default")) {
+        memory_init = INIT_DEFAULT;
+      } else if (!strcmp(optarg, "constraint")) {
+        memory_init = INIT_CONSTRAINT;
+      } else if (!strcmp(optarg, "auto")) {
+        memory_init = INIT_AUTO;
+      } else {
+        fprintf(stderr, "Memory init must be 'chain', 'default', "
+                        "'constraint' or 'auto'.\n");
+        return -1;
+      }
+      break;
+    case OPT_MEMORY_REGIONS: // seperate code from data memory
+      memory_regions = true;
+      break;
+    case OPT_ISA_SUBSET: // only emit commands found in the program
+      if (!strcmp(optarg, "auto")) {
+        isa_subset_auto = true;
+      } else if (!strcmp(optarg, "full")) {
+        isa_subset_auto = false;
+      } else {
+        fprintf(stderr, "ISA subset must be 'auto' or 'full'.\n");
+        return -1;
+      }
+      break;
+    case '?':
+      if (optopt == 'o' || optopt == 'i' || optopt == 'k') {
+        fprintf(stderr, "Option -%c requires an argument.\n", optopt);
+      } else {
+        fprintf(stderr,
+                "Unknown option `-%c`. Usage: %s [-o <target>] [-n "
+                "<iterations>] [-p] [-k <steps>] [-a <width>|auto] "
+                "[--isa-subset=auto|full] [--memory-regions] "
+                "[--writeback=shared|chain] "
+                "[--memory-init=chain|default|constraint|auto] "
+                "[--memory-cells=8|32|64] [--store=enable|select] "
+                "[--registers=states|array] [--xlen=32|64] "
+                "[--scalar-memory=<cells>] [--pc-constraint] [--dead-code] "
+                "[--halt[=<exit address>]] [--props=<bad>,...] [--harts=<n>] "
+                "[--accelerate=<bits>] [--fast-forward=<commands>] "
+                "[--fast-forward-to=<pc>] [--fast-forward-state=<file>] "
+                "[--cache-dir=<dir>] [--cache-size=<MiB>] "
+                "<sourcefile>.state [<more instances>.state ...]\n",
+                optopt, argv[0]);
+      }
+      return -1;
+
+    default:
+      fprintf(stderr,
+              "Usage: %s [-o <target>] [-n <iterations>] [-p] [-k <steps>] "
+              "[-a <width>|auto] "
+              "[--isa-subset=auto|full] [--memory-regions] "
+              "[--writeback=shared|chain] "
+              "[--memory-init=chain|default|constraint|auto] "
+              "[--memory-cells=8|32|64] [--store=enable|select] "
+              "[--registers=states|array] [--xlen=32|64] "
+              "[--scalar-memory=<cells>] [--pc-constraint] [--dead-code] "
+              "[--halt[=<exit address>]] [--props=<bad>,...] [--harts=<n>] "
+              "[--accelerate=<bits>] [--fast-forward=<commands>] "
+              "[--fast-forward-to=<pc>] [--fast-forward-state=<file>] "
+              "[--cache-dir=<dir>] [--cache-size=<MiB>] "
+              "<sourcefile>.state [<more instances>.state ...]\n",
+              argv[0]);
+      return -1;
+    }
+  }
+  if (memsize <= cell_shift) {
+    fprintf(stderr, "Address space is too small for the memory cells.\n");
+    return -1;
+  }
+  add_options_to_cache_key(&model_key);
+  return optind;
+}
+
+bool prepare_model(state **states, char **names, int n_states) {
+  n_instances = n_states;
+  for (int i = 0; i < n_instances && cache_dir; i++) {
+    if (!add_state_to_cache_key(&model_key, states[i])) {
+      fprintf(stderr, "State could not be hashed, the cache is not used.\n");
+      cache_dir = NULL;
+    }
+  }
+  state *s = states[0];
+
+  if (!n_harts) {
+    n_harts = count_harts(s);
+  }
+  for (int i = 0; i < n_instances; i++) {
+    if (count_harts(states[i]) > (size_t)n_harts) {
+      if (names) {
+        fprintf(stderr, "%s has more harts than are used.\n", names[i]);
+      } else {
+        fprintf(stderr, "State %d has more harts than are used.\n", i);
+      }
+    }
+    while (count_harts(states[i]) < (size_t)n_harts) {
+      // Harts without registers of their own start like the first
+      copy_registers(create_hart(states[i]), states[i]);
+    }
+  }
+  if (n_harts > 1) {
+    if (big_step > 1) {
+      fprintf(stderr, "Harts execute one command per transition, -k is not "
+                      "used.\n");
+      big_step = 1;
+    }
+    if (max_scalar_cells) {
+      fprintf(stderr, "Scalar memory needs a single hart, the array is "
+                      "used.\n");
+      max_scalar_cells = 0;
+    }
+    if (pc_constraint || dead_code_report) {
+      fprintf(stderr, "Reachable pcs are not known with several harts.\n");
+      pc_constraint = false;
+      dead_code_report = false;
+    }
+    if (address_range_check) {
+      fprintf(stderr, "The address width is not chosen with several harts, "
+                      "the default one is used.\n");
+      address_range_check = false;
+    }
+  }
+  if (!selected_props[BAD_UNKNOWN_OPCODE] || !selected_props[BAD_COMMAND] ||
+      !selected_props[BAD_MISALIGNED]) {
+    // The analyses end paths at bad commands, the model goes on after them
+    if (isa_subset_auto) {
+      fprintf(stderr, "The ISA subset needs the opcode, command and "
+                      "misaligned props, the full ISA is used.\n");
+      isa_subset_auto = false;
+    }
+    if (max_scalar_cells) {
+      fprintf(stderr, "Scalar memory needs the opcode, command and "
+                      "misaligned props, the array is used.\n");
+      max_scalar_cells = 0;
+    }
+    if (address_range_check) {
+      fprintf(stderr, "The address width is not chosen without the opcode, "
+                      "command and misaligned props, the default one is "
+                      "used.\n");
+      address_range_check = false;
+    }
+    if (pc_constraint) {
+      fprintf(stderr, "Reachable pcs need the opcode, command and misaligned "
+                      "props, the pc is not constrained.\n");
+      pc_constraint = false;
+    }
+  }
+
+  if (!xlen) {
+    xlen = s->xlen;
+    for (int i = 1; i < n_instances; i++) {
+      if (states[i]->xlen != xlen) {
+        fprintf(stderr, "Instances differ in their register width, it has to "
+                        "be given by --xlen.\n");
+        return false;
+      }
+    }
+  }
+  if (address_range_check) {
+    memsize = 0;
+    for (int i = 0; i < n_instances; i++) {
+      int width = auto_address_width(states[i]);
+      memsize = width > memsize ? width : memsize;
+    }
+    pow_memsize = (uint64_t)1 << memsize;
+    address_range_check = memsize < xlen; // nothing can be out of range
+  }
+  if (memsize > xlen) {
+    fprintf(stderr, "Address space is wider than the registers.\n");
+    return false;
+  }
+  register_sort = xlen == 32 ? 5 : 6;
+
+  bool symbolic_memory = false;
+  for (int i = 0; i < n_instances; i++) {
+    symbolic_memory |= has_symbolic_memory(states[i]);
+  }
+  if (symbolic_memory) { // any byte could hold a command
+    if (isa_subset_auto) {
+      fprintf(stderr, "Symbolic memory needs the full ISA.\n");
+      isa_subset_auto = false;
+    }
+    if (memory_regions) {
+      fprintf(stderr, "Symbolic memory is not used with memory regions.\n");
+      memory_regions = false;
+    }
+  }
+  if (isa_subset_auto) {
+    find_used_commands(s, pow_memsize, used_commands);
+    for (int i = 0; i < n_instances * n_harts; i++) {
+      bool used[COMMAND_COUNT]; // commands are aligned to the pc of each hart
+      find_used_commands(get_hart(states[i / n_harts], i % n_harts),
+                         pow_memsize, used);
+      for (int command = 0; command < COMMAND_COUNT; command++) {
+        used_commands[command] |= used[command];
+      }
+    }
+  }
+  if (memory_regions &&
+      !find_code_region(s, pow_memsize, &code_start, &code_end)) {
+    fprintf(stderr, "No command at pc, memory regions are not used.\n");
+    memory_regions = false;
+  }
+  for (int i = 1; i < n_instances && memory_regions; i++) {
+    if (!has_code_of(states[i], s)) {
+      fprintf(stderr, "Instance %d has other code, memory regions are not "
+                      "used.\n",
+              i);
+      memory_regions = false;
+    }
+  }
+  if (fast_forward_to_pc && !fast_forward_steps) {
+    fast_forward_steps = MAX_FAST_FORWARD;
+  }
+  if (fast_forward_steps && (n_instances > 1 || n_harts > 1)) {
+    fprintf(stderr, "Only a single state and hart is fast-forwarded.\n");
+    fast_forward_steps = 0;
+  }
+  if (fast_forward_steps) {
+    // The subset and the code region stay the ones of the initial state
+    if (model_iterations >= 0 &&
+        fast_forward_steps > (uint64_t)model_iterations) {
+      fast_forward_steps = model_iterations;
+    }
+    state *initial = big_step > 1 ? copy_state(s) : NULL;
+    if (big_step > 1 && !initial) {
+      fprintf(stderr, "Failed to copy the state to fast-forward.\n");
+      return false;
+    }
+    counter_start = fast_forward(s, fast_forward_steps);
+    if (counter_start % big_step) {
+      // The counter only meets -n at multiples of -k, the run is repeated
+      // to the last one. The caller keeps its pointer to the state.
+      counter_start -= counter_start % big_step;
+      state run = *s;
+      *s = *initial;
+      *initial = run;
+      fast_forward(s, counter_start);
+    }
+    if (initial) {
+      kill_state(initial);
+    }
+  }
+  if (fast_forward_file) {
+    FILE *end_state = fopen(fast_forward_file, "w");
+    if (!end_state) {
+      fprintf(stderr, "Failed to open state file: %s\n", fast_forward_file);
+      return false;
+    }
+    echo_state(s, end_state);
+    fclose(end_state);
+  }
+  if (max_scalar_cells && n_instances > 1) {
+    fprintf(stderr, "Scalar memory needs a single state, the array is "
+                    "used.\n");
+  } else if (max_scalar_cells && (cell_bytes > 1 || store_select)) {
+    fprintf(stderr, "Scalar memory needs byte cells and enabled stores, the "
+                    "array is used.\n");
+  } else if (max_scalar_cells) {
+    scalar_addresses = malloc(max_scalar_cells * sizeof(uint64_t));
+    scalar_kinds = malloc(max_scalar_cells);
+    scalar_cells = find_memory_footprint(s, pow_memsize, xlen,
+                                         scalar_addresses, scalar_kinds,
+                                         max_scalar_cells);
+    size_t n_cells = 0;
+    for (size_t limit = 2 * max_scalar_cells;
+         !scalar_cells && !n_cells && limit <= AUTO_WIDTH_CELLS; limit *= 2) {
+      // With room for more cells, a bounded footprint is counted. Larger
+      // value sets can run out of work, so the room grows step by step.
+      uint64_t *cells = malloc(limit * sizeof(uint64_t));
+      uint8_t *kinds = malloc(limit);
+      n_cells = find_memory_footprint(s, pow_memsize, xlen, cells, kinds,
+                                      limit);
+      free(cells);
+      free(kinds);
+    }
+    if (n_cells) {
+      fprintf(stderr, "Memory footprint has %zu cells, more than %zu, the "
+                      "array is used.\n",
+              n_cells, max_scalar_cells);
+    } else if (!scalar_cells) {
+      fprintf(stderr, "Memory footprint is not bounded, the array is used.\n");
+    }
+    for (size_t i = 0; i < scalar_cells; i++) {
+      if ((scalar_kinds[i] & FOOTPRINT_FETCH) &&
+          (scalar_kinds[i] & FOOTPRINT_STORE)) {
+        fprintf(stderr, "Code could be overwritten, the array is used.\n");
+        scalar_cells = 0;
+      }
+    }
+    // Stored cells first, so a memory after stores is one block of states
+    size_t stored = 0;
+    for (size_t i = 0; i < scalar_cells; i++) {
+      if (scalar_kinds[i] & FOOTPRINT_STORE) {
+        uint64_t address = scalar_addresses[i];
+        uint8_t kind = scalar_kinds[i];
+        memmove(scalar_addresses + stored + 1, scalar_addresses + stored,
+                (i - stored) * sizeof(uint64_t));
+        memmove(scalar_kinds + stored + 1, scalar_kinds + stored, i - stored);
+        scalar_addresses[stored] = address;
+        scalar_kinds[stored] = kind;
+        stored++;
+      }
+    }
+    scalar_stored = stored;
+  }
+
+  if (accelerate_bits && (n_instances > 1 || n_harts > 1)) {
+    fprintf(stderr, "Loops are only accelerated for a single state and "
+                    "hart.\n");
+    accelerate_bits = 0;
+  }
+  if (accelerate_bits && scalar_cells && big_step > 1) {
+    fprintf(stderr, "Loops are not accelerated on scalar memory with -k.\n");
+    accelerate_bits = 0;
+  }
+  if (accelerate_bits) {
+    loops = malloc(MAX_LOOPS * sizeof(counting_loop));
+    size_t found =
+        find_counting_loops(s, pow_memsize, xlen, loops, MAX_LOOPS);
+    bool loop_stores = false;
+    for (size_t i = 0; i < found; i++) {
+      bool stores = false;
+      for (size_t j = 0; j < loops[i].n_body; j++) {
+        stores |= loop_store_bytes(&loops[i].body[j]) > 0;
+      }
+      if (halt_at_exit && exit_address >= loops[i].head &&
+          exit_address < loops[i].end) {
+        continue; // reaching the exit is bad
+      }
+      if (stores && scalar_cells) {
+        continue; // the footprint does not know the jumps
+      }
+      loops[n_loops] = loops[i];
+      n_loops++;
+      loop_stores |= stores;
+    }
+    if (!n_loops) {
+      fprintf(stderr, "No counting loop found, nothing is accelerated.\n");
+      accelerate_bits = 0;
+    }
+    if (loop_stores && accelerate_bits > MAX_STORE_ACCELERATE) {
+      // Every iteration that can be jumped over has its own stores
+      fprintf(stderr, "Loops with stores are unrolled, %d bits are "
+                      "accelerated.\n",
+              MAX_STORE_ACCELERATE);
+      accelerate_bits = MAX_STORE_ACCELERATE;
+    }
+  }
+  if (pc_constraint || dead_code_report) {
+    reachable_pcs = calloc(n_instances, sizeof(uint64_t *));
+    n_reachable_pcs = calloc(n_instances, sizeof(size_t));
+  }
+  for (int i = 0; i < n_instances && (pc_constraint || dead_code_report);
+       i++) {
+    reachable_pcs[i] = malloc(MAX_REACHABLE_PCS * sizeof(uint64_t));
+    n_reachable_pcs[i] = find_reachable_pcs(
+        states[i], pow_memsize, xlen, reachable_pcs[i], MAX_REACHABLE_PCS);
+    if (n_instances > 1) {
+      fprintf(stderr, "Instance %d:\n", i);
+    }
+    if (!n_reachable_pcs[i]) {
+      fprintf(stderr, "Control flow is not bounded, reachable pcs are "
+                      "unknown.\n");
+    } else if (dead_code_report) {
+      report_dead_code(states[i], reachable_pcs[i], n_reachable_pcs[i]);
+    }
+  }
+  return true;
+}
+
+bool write_model(writer *out, state **states) {
+  bool write_failed = false;
+  FILE *cached = cache_dir ? open_cached_model(cache_dir, &model_key) : NULL;
+  bool cache_hit = cached != NULL;
+  char new_path[4096];
+  FILE *new_model = NULL; // on a miss the cache gets the model first
+  writer *model_target = out;
+  if (cache_dir && !cached) {
+    new_model = create_cached_model(cache_dir, new_path, sizeof(new_path));
+    model_target = new_model ? open_writer(fileno(new_model)) : NULL;
+    if (!model_target) {
+      fprintf(stderr, "Failed to add to the model cache: %s\n", cache_dir);
+      if (new_model) {
+        fclose(new_model);
+        unlink(new_path);
+        new_model = NULL;
+      }
+      model_target = out;
+    }
+  }
+  if (cached) {
+    bwrite_file(out, cached);
+    fclose(cached);
+  } else if (slice_props) {
+    // Unused logic is only known once the model is complete
+    FILE *model = tmpfile();
+    writer *model_out = model ? open_writer(fileno(model)) : NULL;
+    if (!model_out) {
+      fprintf(stderr, "Failed to open a temporary file for the model.\n");
+      return false;
+    }
+    relational_btor(model_out, states, model_iterations);
+    write_failed = close_writer(model_out) < 0;
+    rewind(model);
+    if (write_cone_of_influence(model, model_target) < 0) {
+      fprintf(stderr, "Model could not be sliced, it is written whole.\n");
+      rewind(model);
+      bwrite_file(model_target, model);
+    }
+    fclose(model);
+  } else {
+    relational_btor(model_target, states, model_iterations);
+  }
+  if (new_model) {
+    // Complete models only, then it is copied to the output
+    write_failed |= close_writer(model_target) < 0;
+    rewind(new_model);
+    if (!write_failed) {
+      bwrite_file(out, new_model);
+    }
+    fclose(new_model);
+    if (write_failed ||
+        !store_cached_model(cache_dir, new_path, &model_key, cache_bytes)) {
+      unlink(new_path);
+    }
+  }
+  if (cache_dir) {
+    uint64_t hits;
+    uint64_t misses;
+    count_cache_use(cache_dir, cache_hit, &hits, &misses);
+    fprintf(stderr, "Model cache %s, %lu hits and %lu misses in %s.\n",
+            cache_hit ? "hit" : "miss", hits, misses, cache_dir);
+  }
+  return !write_failed;
+}
+
+void release_model(void) {
+  free(scalar_addresses);
+  free(scalar_kinds);
+  free(loops);
+  for (int i = 0; i < n_instances && reachable_pcs; i++) {
+    free(reachable_pcs[i]);
+  }
+  free(reachable_pcs);
+  free(n_reachable_pcs);
+  scalar_addresses = NULL;
+  scalar_kinds = NULL;
+  loops = NULL;
+  reachable_pcs = NULL;
+  n_reachable_pcs = NULL;
+}
+
+bool emit_model(writer *out, state **states, char **names, int n_states) {
+  bool emitted =
+      prepare_model(states, names, n_states) && write_model(out, states);
+  release_model();
+  return emitted;
+}
@@ -0,0 +1,33 @@
+#include "./state.h"
+#include "./writer.h"
+#include <stdbool.h>
+
+#ifndef MODEL
+#define MODEL
+
+// The BTOR2 model riscv_to_btor2 emits, for use within other programs. The
+// options stay until the next set_model_options, so a process can convert
+// many states in turn. Messages go to stderr like those of the tool.
+
+// Resets all options and takes the ones in argv as riscv_to_btor2 does, argv[0]
+// is the program name. -o and -p are written to target and to_stdout, they are
+// skipped if those are NULL. Returns the index of the first state file in
+// argv, -1 if an option is invalid.
+int set_model_options(int argc, char *argv[], char **target, bool *to_stdout);
+
+// Checks the states against the options and finds what the model needs. The
+// states are changed: harts are added and fast-forward executes the first one.
+// names are used in messages, NULL numbers the states instead. Returns false
+// if there is no model for them, release_model is needed either way.
+bool prepare_model(state **states, char **names, int n_states);
+
+// Writes the model of the prepared states. Returns false if a write failed.
+bool write_model(writer *out, state **states);
+
+// Frees what prepare_model found, the states stay with the caller
+void release_model(void);
+
+// prepare_model, write_model and release_model at once
+bool emit_model(writer *out, state **states, char **names, int n_states);
+
+#endif // MODEL
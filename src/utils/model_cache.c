@@ -0,0 +1,226 @@
+#include "./model_cache.h"
+#include "./state.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CACHE_FORMAT "riscv_to_btor2 model cache 1"
+#define MODEL_SUFFIX ".btor2"
+#define TEMP_PREFIX ".model."
+#define STALE_TEMP_SECONDS 3600 // left by a run that did not finish
+#define STATISTICS_FILE "statistics"
+
+typedef struct cached_file {
+  char name[64];
+  uint64_t bytes;
+  struct timespec used;
+} cached_file;
+
+void start_cache_key(cache_key *k, const char *program) {
+  k->lanes[0] = 0xcbf29ce484222325; // FNV-1a offset basis
+  k->lanes[1] = 0x84222325cbf29ce4;
+  add_to_cache_key(k, CACHE_FORMAT, sizeof(CACHE_FORMAT));
+  struct stat tool;
+  if (stat("/proc/self/exe", &tool) && stat(program, &tool)) {
+    add_to_cache_key(k, program, strlen(program) + 1);
+    return;
+  }
+  uint64_t version[3] = {tool.st_size, tool.st_mtim.tv_sec,
+                         tool.st_mtim.tv_nsec};
+  add_to_cache_key(k, version, sizeof(version));
+}
+
+void add_to_cache_key(cache_key *k, const void *data, size_t n) {
+  const uint8_t *bytes = data;
+  for (size_t i = 0; i < n; i++) {
+    k->lanes[0] = (k->lanes[0] ^ bytes[i]) * 0x100000001b3;
+    k->lanes[1] = (k->lanes[1] ^ bytes[i]) * 0x100000001b3;
+    k->lanes[1] ^= k->lanes[1] >> 29; // so both lanes do not collide at once
+  }
+}
+
+bool add_state_to_cache_key(cache_key *k, state *s) {
+  char *text = NULL;
+  size_t length = 0;
+  FILE *echo = open_memstream(&text, &length);
+  if (!echo) {
+    return false;
+  }
+  echo_state(s, echo);
+  bool written = !ferror(echo);
+  fclose(echo);
+  add_to_cache_key(k, text, length);
+  add_to_cache_key(k, "", 1); // ends the state
+  free(text);
+  return written;
+}
+
+static uint64_t finish_lane(uint64_t lane) {
+  // FNV leaves the last bytes in the low bits only
+  lane ^= lane >> 33;
+  lane *= 0xff51afd7ed558ccd;
+  lane ^= lane >> 33;
+  lane *= 0xc4ceb9fe1a85ec53;
+  return lane ^ (lane >> 33);
+}
+
+static void model_name(cache_key *k, char *name, size_t size) {
+  snprintf(name, size, "%016lx%016lx" MODEL_SUFFIX, finish_lane(k->lanes[0]),
+           finish_lane(k->lanes[1]));
+}
+
+static void model_path(const char *dir, cache_key *k, char *path,
+                       size_t size) {
+  char name[64];
+  model_name(k, name, sizeof(name));
+  snprintf(path, size, "%s/%s", dir, name);
+}
+
+FILE *open_cached_model(const char *dir, cache_key *k) {
+  char path[4096];
+  model_path(dir, k, path, sizeof(path));
+  FILE *model = fopen(path, "r");
+  if (model) {
+    utimensat(AT_FDCWD, path, NULL, 0); // the time of use orders eviction
+  }
+  return model;
+}
+
+FILE *create_cached_model(const char *dir, char *path, size_t size) {
+  if (mkdir(dir, 0777) && errno != EEXIST) {
+    return NULL;
+  }
+  if ((size_t)snprintf(path, size, "%s/" TEMP_PREFIX "XXXXXX", dir) >= size) {
+    return NULL;
+  }
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    return NULL;
+  }
+  mode_t mask = umask(0);
+  umask(mask);
+  fchmod(fd, 0666 & ~mask); // like any other output, not private
+  FILE *model = fdopen(fd, "w+");
+  if (!model) {
+    close(fd);
+    unlink(path);
+  }
+  return model;
+}
+
+static int compare_use(const void *a, const void *b) {
+  const struct timespec *x = &((const cached_file *)a)->used;
+  const struct timespec *y = &((const cached_file *)b)->used;
+  if (x->tv_sec != y->tv_sec) {
+    return x->tv_sec < y->tv_sec ? -1 : 1;
+  }
+  return (x->tv_nsec > y->tv_nsec) - (x->tv_nsec < y->tv_nsec);
+}
+
+static void evict_models(const char *dir, uint64_t max_bytes) {
+  // Oldest first, until the rest fits
+  DIR *d = opendir(dir);
+  if (!d) {
+    return;
+  }
+  size_t n = 0;
+  size_t capacity = 64;
+  cached_file *files = malloc(capacity * sizeof(cached_file));
+  uint64_t total = 0;
+  time_t now = time(NULL);
+  struct dirent *entry;
+  while (files && (entry = readdir(d))) {
+    size_t length = strlen(entry->d_name);
+    bool is_model = length > strlen(MODEL_SUFFIX) &&
+                    length < sizeof(files->name) &&
+                    !strcmp(entry->d_name + length - strlen(MODEL_SUFFIX),
+                            MODEL_SUFFIX);
+    bool is_temp = !strncmp(entry->d_name, TEMP_PREFIX, strlen(TEMP_PREFIX));
+    struct stat info;
+    if ((!is_model && !is_temp) ||
+        fstatat(dirfd(d), entry->d_name, &info, 0)) {
+      continue;
+    }
+    if (is_temp) {
+      if (now - info.st_mtime > STALE_TEMP_SECONDS) {
+        unlinkat(dirfd(d), entry->d_name, 0);
+      }
+      continue;
+    }
+    if (n == capacity) {
+      capacity *= 2;
+      cached_file *more = realloc(files, capacity * sizeof(cached_file));
+      if (!more) {
+        break;
+      }
+      files = more;
+    }
+    strcpy(files[n].name, entry->d_name);
+    files[n].bytes = info.st_size;
+    files[n].used = info.st_mtim;
+    total += info.st_size;
+    n++;
+  }
+  if (files && total > max_bytes) {
+    qsort(files, n, sizeof(cached_file), compare_use);
+    for (size_t i = 0; i < n && total > max_bytes; i++) {
+      if (!unlinkat(dirfd(d), files[i].name, 0)) {
+        total -= files[i].bytes;
+      }
+    }
+  }
+  free(files);
+  closedir(d);
+}
+
+bool store_cached_model(const char *dir, const char *path, cache_key *k,
+                        uint64_t max_bytes) {
+  char target[4096];
+  model_path(dir, k, target, sizeof(target));
+  if (rename(path, target)) {
+    unlink(path);
+    return false;
+  }
+  evict_models(dir, max_bytes);
+  return true;
+}
+
+void count_cache_use(const char *dir, bool hit, uint64_t *hits,
+                     uint64_t *misses) {
+  // Runs share the counts, so they are changed under a lock
+  *hits = hit;
+  *misses = !hit;
+  char path[4096];
+  snprintf(path, sizeof(path), "%s/" STATISTICS_FILE, dir);
+  int fd = open(path, O_RDWR | O_CREAT, 0666);
+  if (fd < 0) {
+    return;
+  }
+  FILE *counts = fdopen(fd, "r+");
+  if (!counts) {
+    close(fd);
+    return;
+  }
+  flock(fd, LOCK_EX);
+  uint64_t old_hits = 0;
+  uint64_t old_misses = 0;
+  if (fscanf(counts, "hits %lu misses %lu", &old_hits, &old_misses) == 2) {
+    *hits += old_hits;
+    *misses += old_misses;
+  }
+  rewind(counts);
+  fprintf(counts, "hits %lu misses %lu\n", *hits, *misses);
+  fflush(counts);
+  ftruncate(fd, ftell(counts));
+  flock(fd, LOCK_UN);
+  fclose(counts);
+}
@@ -0,0 +1,41 @@
+#include "./state.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef MODEL_CACHE
+#define MODEL_CACHE
+
+#define MODEL_CACHE_SIZE 1024 // MiB of models kept, without --cache-size
+
+// Hash of everything a model depends on, two 64 bit lanes
+typedef struct cache_key {
+  uint64_t lanes[2];
+} cache_key;
+
+// Starts the key with the tool itself, its executable changes with every build
+void start_cache_key(cache_key *k, const char *program);
+void add_to_cache_key(cache_key *k, const void *data, size_t n);
+// Adds the state as echo_state writes it, which does not depend on the order
+// or comments of its file. Returns false if it could not be written.
+bool add_state_to_cache_key(cache_key *k, state *s);
+
+// Opens the model of the key for reading and marks it as recently used.
+// Returns NULL if it is not cached.
+FILE *open_cached_model(const char *dir, cache_key *k);
+
+// Opens a temporary file in dir for a new model, its name is written to path.
+// dir is created if it does not exist. Returns NULL if that fails.
+FILE *create_cached_model(const char *dir, char *path, size_t size);
+
+// Renames the complete model at path to the one of the key, so readers never
+// see a partial one. The least recently used models are removed until all of
+// them fit into max_bytes.
+bool store_cached_model(const char *dir, const char *path, cache_key *k,
+                        uint64_t max_bytes);
+
+// Counts a hit or a miss in dir and returns the counts so far
+void count_cache_use(const char *dir, bool hit, uint64_t *hits,
+                     uint64_t *misses);
+
+#endif // MODEL_CACHE
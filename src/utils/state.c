@@ -8,7 +8,7 @@
 
 #define LOAD_BUFFER_SIZE 81  // At least 32!
 #define NAME_BUFFER_SIZE 32  // At least 10!
-#define VALUE_BUFFER_SIZE 32 // At least 22!
+#define VALUE_BUFFER_SIZE 48 // At least 38 for symbolic ranges!
 
 uint8_t get_byte(state *s, uint64_t address) {
   uint32_t hashed_address = hash(address);
@@ -135,6 +135,22 @@ void set_register(state *s, uint8_t register_number, uint64_t value) {
   s->regs_init[register_number] = true;
 }
 void set_pc(state *s, uint64_t value) { s->pc = value; }
+void set_symbolic_register(state *s, uint8_t register_number, uint64_t min,
+                           uint64_t max) {
+  set_register(s, register_number, min);
+  s->regs_symbolic[register_number] = true;
+  s->regs_min[register_number] = min;
+  s->regs_max[register_number] = max;
+}
+void add_symbolic_memory(state *s, uint64_t start, uint64_t end, uint8_t min,
+                         uint8_t max) {
+  s->symbolic_memory =
+      realloc(s->symbolic_memory,
+              (s->n_symbolic_memory + 1) * sizeof(symbolic_range));
+  s->symbolic_memory[s->n_symbolic_memory] =
+      (symbolic_range){start, end, min, max};
+  s->n_symbolic_memory++;
+}
 void next_pc(state *s) { s->pc += 4; }
 
 char *byte_to_hex(char *dest, uint8_t b) {
@@ -156,7 +172,10 @@ bool pretty_print(state *s) {
   for (size_t i = 0; i < 32; i++) {
     if (s->regs_init[i]) {
       int64_t value_signed = s->regs_values[i];
-      printf("  x%ld:%lx  #(%ld)\n", i, value_signed, value_signed);
+      if (s->xlen == 32) {
+        value_signed = (int32_t)value_signed;
+      }
+      printf("  x%ld:%lx  #(%ld)\n", i, s->regs_values[i], value_signed);
     }
   }
 
@@ -172,7 +191,7 @@ bool pretty_print(state *s) {
     printf("  %lx: ", addresses[n_printed_values + 1]);
     space = false;
     uint8_t chain = 0;
-    for (size_t i = 0; i < 8; i++) {
+    for (size_t i = 0; i < 8 && n_printed_values + i < addresses[0]; i++) {
       if (i == addresses[n_printed_values + i + 1] -
                    addresses[n_printed_values + 1]) {
         chain++;
@@ -218,10 +237,66 @@ bool is_address_initialised(state *s, uint64_t address,
 bool is_register_initialised(state *s, uint8_t register_number) {
   return s->regs_init[register_number];
 }
+bool is_register_symbolic(state *s, uint8_t register_number) {
+  return s->regs_symbolic[register_number];
+}
+symbolic_range *find_symbolic_range(state *s, uint64_t address) {
+  // Later ranges win, like later lines of the state file
+  for (size_t i = s->n_symbolic_memory; i > 0; i--) {
+    symbolic_range *range = &s->symbolic_memory[i - 1];
+    if (range->start <= address && address <= range->end) {
+      return range;
+    }
+  }
+  return NULL;
+}
+bool has_symbolic_memory(state *s) { return s->n_symbolic_memory > 0; }
+
+state *create_hart(state *s) {
+  state *hart = malloc(sizeof(state));
+  *hart = *s;
+  for (size_t i = 0; i < 32; i++) {
+    hart->regs_values[i] = 0;
+    hart->regs_init[i] = i == 0;
+    hart->regs_symbolic[i] = false;
+  }
+  hart->pc = 0;
+  hart->symbolic_memory = NULL; // the memory stays with the first state
+  hart->n_symbolic_memory = 0;
+  hart->next_hart = NULL;
+  while (s->next_hart) {
+    s = s->next_hart;
+  }
+  s->next_hart = hart;
+  return hart;
+}
+state *get_hart(state *s, size_t hart) {
+  for (size_t i = 0; i < hart && s; i++) {
+    s = s->next_hart;
+  }
+  return s;
+}
+size_t count_harts(state *s) {
+  size_t n = 0;
+  for (; s; s = s->next_hart) {
+    n++;
+  }
+  return n;
+}
+void copy_registers(state *target, state *source) {
+  target->pc = source->pc;
+  memcpy(target->regs_values, source->regs_values, sizeof(source->regs_values));
+  memcpy(target->regs_init, source->regs_init, sizeof(source->regs_init));
+  memcpy(target->regs_symbolic, source->regs_symbolic,
+         sizeof(source->regs_symbolic));
+  memcpy(target->regs_min, source->regs_min, sizeof(source->regs_min));
+  memcpy(target->regs_max, source->regs_max, sizeof(source->regs_max));
+}
 
 state *create_new_state() {
   state *new = malloc(sizeof(state));
   new->pc = 0;
+  new->xlen = 64;
 
   new->regs_values[0] = 0;
   new->regs_init[0] = true;
@@ -229,7 +304,15 @@ state *create_new_state() {
     new->regs_values[i] = 0;
     new->regs_init[i] = false;
   }
+  for (size_t i = 0; i < 32; i++) {
+    new->regs_symbolic[i] = false;
+    new->regs_min[i] = 0;
+    new->regs_max[i] = 0;
+  }
   new->memory = create_memory_table();
+  new->symbolic_memory = NULL;
+  new->n_symbolic_memory = 0;
+  new->next_hart = NULL;
 
   return new;
 }
@@ -258,6 +341,23 @@ void remove_whitespace(char *str) {
       '\0'; // terminate string and cut off maybe left non moved chars
 }
 
+bool parse_symbolic(char *value, uint64_t *min, uint64_t *max) {
+  // "?" leaves the value to the solver, "? <min>-<max>" bounds it (hex)
+  while (*value == ' ' || *value == '\t') {
+    value++;
+  }
+  if (*value != '?') {
+    return false;
+  }
+  char *end;
+  uint64_t low = strtoull(value + 1, &end, 16);
+  if (end != value + 1 && *end == '-') {
+    *min = low;
+    *max = strtoull(end + 1, NULL, 16);
+  }
+  return true;
+}
+
 void remove_comment(char *str) {
   for (size_t i = 0; i < LOAD_BUFFER_SIZE; i++) {
     if (str[i] == '#') {
@@ -266,39 +366,21 @@ void remove_comment(char *str) {
   }
 }
 
-bool load_state(char *filename, state *s) {
-  FILE *state_file = fopen(filename, "r");
-  if (!state_file) {
-    printf("ERROR: No state-file\n");
-    return false;
-  }
-  // file exists
-  char buffer[LOAD_BUFFER_SIZE]; // expected max size: 9 chars for mem_address
-                                 // in hex, 19 chars for 64bit storage
-                                 // representation in hex, 4 chars for
-                                 // "; " and "/n/0"
-  char *buffer_valid;            // either NULL or buffer
-  buffer_valid = fgets(buffer, sizeof(buffer), state_file);
-  if (strcmp(buffer, "REGISTERS:\n") != 0) {
-    printf("ERROR: state-file not starting with 'REGISTERS:'\n");
-    return false;
-  }
-
+char *load_registers(FILE *state_file, state *s, char *buffer, int size) {
+  // Reads the lines of a register section up to the empty line after it
+  char *buffer_valid;
   char *dp_pointer;
-  char name_buffer[NAME_BUFFER_SIZE]; // longest possible register will be ft11
-                                      // (if implemented), 32bit address has 9
-                                      // chars (2x4 hexcode
-                                      // + ' ')
-  char value_buffer[VALUE_BUFFER_SIZE]; // All values, addresses,
+  char name_buffer[NAME_BUFFER_SIZE];
+  char value_buffer[VALUE_BUFFER_SIZE];
   uint8_t name_length;
 
-  buffer_valid = fgets(buffer, sizeof(buffer), state_file);
+  buffer_valid = fgets(buffer, size, state_file);
   remove_comment(buffer);
 
   while (buffer_valid && strncmp(buffer, "\n", 1)) {
     dp_pointer = strchr(buffer, ':');
     if (!dp_pointer) {
-      buffer_valid = fgets(buffer, sizeof(buffer), state_file);
+      buffer_valid = fgets(buffer, size, state_file);
       remove_comment(buffer);
       continue;
     }
@@ -316,15 +398,29 @@ bool load_state(char *filename, state *s) {
       s->pc = strtoul(value_buffer, NULL, 16);
       break;
 
+    case 'X': // register width in decimal, RV64 without it
+      s->xlen = strtol(value_buffer, NULL, 10);
+      if (s->xlen != 32 && s->xlen != 64) {
+        printf("ERROR: XLEN must be 32 or 64, got %d\n", s->xlen);
+        s->xlen = 64;
+      }
+      break;
+
     case 'x':
       int16_t reg_num = strtol(name_buffer + 1, NULL, 10);
       int64_t reg_value = strtoul(value_buffer, NULL, 16);
+      uint64_t reg_min = 0;
+      uint64_t reg_max = UINT64_MAX;
+      bool symbolic = parse_symbolic(value_buffer, &reg_min, &reg_max);
       if (reg_num > 31 || reg_num < 0) {
         printf("ERROR: register x%d out of range\n", reg_num);
         break;
-      } else if (reg_num == 0 && reg_value) { // x0 initialised with not 0
+      } else if (reg_num == 0 && (reg_value || symbolic)) {
         printf("ERROR: x0 is always 0\n");
         break;
+      } else if (symbolic) {
+        set_symbolic_register(s, reg_num, reg_min, reg_max);
+        break;
       }
 
       s->regs_values[reg_num] = reg_value;
@@ -335,13 +431,63 @@ bool load_state(char *filename, state *s) {
       printf("ERROR: register name %s unknown\n", name_buffer);
       break;
     }
-    buffer_valid = fgets(buffer, sizeof(buffer), state_file);
+    buffer_valid = fgets(buffer, size, state_file);
     remove_comment(buffer);
   }
+  return buffer_valid;
+}
 
+bool load_state(char *filename, state *s) {
+  FILE *state_file = fopen(filename, "r");
+  if (!state_file) {
+    printf("ERROR: No state-file\n");
+    return false;
+  }
+  bool loaded = load_state_stream(state_file, s);
+  fclose(state_file);
+  return loaded;
+}
+
+bool load_state_buffer(const char *data, size_t length, state *s) {
+  FILE *state_file = fmemopen((void *)data, length, "r");
+  if (!state_file) {
+    return false;
+  }
+  bool loaded = load_state_stream(state_file, s);
+  fclose(state_file);
+  return loaded;
+}
+
+bool load_state_stream(FILE *state_file, state *s) {
+  char buffer[LOAD_BUFFER_SIZE]; // expected max size: 9 chars for mem_address
+                                 // in hex, 19 chars for 64bit storage
+                                 // representation in hex, 4 chars for
+                                 // "; " and "/n/0"
+  char *buffer_valid;            // either NULL or buffer
+  buffer_valid = fgets(buffer, sizeof(buffer), state_file);
+  if (strcmp(buffer, "REGISTERS:\n") != 0) {
+    printf("ERROR: state-file not starting with 'REGISTERS:'\n");
+    return false;
+  }
+
+  char *dp_pointer;
+  char name_buffer[NAME_BUFFER_SIZE]; // longest possible register will be ft11
+                                      // (if implemented), 32bit address has 9
+                                      // chars (2x4 hexcode
+                                      // + ' ')
+  char value_buffer[VALUE_BUFFER_SIZE]; // All values, addresses,
+  uint8_t name_length;
+
+  load_registers(state_file, s, buffer, sizeof(buffer));
   buffer_valid = fgets(buffer, sizeof(buffer), state_file);
   remove_comment(buffer);
-  if (strncmp(buffer, "MEMORY:", 7) != 0) {
+  // Every further register section is one more hart on the same memory
+  while (buffer_valid && !strcmp(buffer, "REGISTERS:\n")) {
+    load_registers(state_file, create_hart(s), buffer, sizeof(buffer));
+    buffer_valid = fgets(buffer, sizeof(buffer), state_file);
+    remove_comment(buffer);
+  }
+  if (!buffer_valid || strncmp(buffer, "MEMORY:", 7) != 0) {
     printf("ERROR: state-file does not include 'MEMORY:'\n");
     return false;
   }
@@ -365,7 +511,19 @@ bool load_state(char *filename, state *s) {
     remove_whitespace(name_buffer);
     remove_whitespace(value_buffer);
 
-    uint64_t address = strtoul(name_buffer, NULL, 16);
+    char *range_end;
+    uint64_t address = strtoul(name_buffer, &range_end, 16);
+    uint64_t byte_min = 0;
+    uint64_t byte_max = 0xff;
+    if (parse_symbolic(value_buffer, &byte_min, &byte_max)) {
+      // A single address or an inclusive range "<start>-<end>"
+      uint64_t end =
+          *range_end == '-' ? strtoul(range_end + 1, NULL, 16) : address;
+      add_symbolic_memory(s, address, end, byte_min, byte_max);
+      buffer_valid = fgets(buffer, sizeof(buffer), state_file);
+      remove_comment(buffer);
+      continue;
+    }
     // if (address >= MEMORY_SIZE) {
     //   printf("ERROR: memory address %x out of current bounds of %d\n",
     //   address,
@@ -395,29 +553,56 @@ bool load_state(char *filename, state *s) {
     remove_comment(buffer);
   }
 
-  fclose(state_file);
-
   return true;
 }
 
+void kill_harts(state *s) {
+  // Further harts share the memory of the first
+  while (s->next_hart) {
+    state *hart = s->next_hart;
+    s->next_hart = hart->next_hart;
+    free(hart);
+  }
+}
+
 bool kill_state(state *s) {
+  kill_harts(s);
   kill_memory_table(s->memory);
+  free(s->symbolic_memory);
   free(s);
 
   return true;
 }
 
-bool echo_and_kill_state_keep_seed(state *s, FILE *end_state, uint32_t *seed) {
-  fprintf(end_state, "REGISTERS:\n");
-  if (seed != NULL) {
-    fprintf(end_state, "# seed %u\n", *seed);
-  }
+void echo_registers(state *s, FILE *end_state) {
   fprintf(end_state, "PC:%lx\n", s->pc);
+  if (s->xlen != 64) {
+    fprintf(end_state, "XLEN:%d\n", s->xlen);
+  }
+  uint64_t register_mask = s->xlen == 32 ? 0xffffffff : UINT64_MAX;
   for (size_t i = 0; i < 32; i++) {
-    if (s->regs_init[i]) {
+    if (s->regs_symbolic[i] &&
+        (s->regs_min[i] || (s->regs_max[i] & register_mask) != register_mask)) {
+      fprintf(end_state, "x%ld:? %lx-%lx\n", i, s->regs_min[i],
+              s->regs_max[i]);
+    } else if (s->regs_symbolic[i]) {
+      fprintf(end_state, "x%ld:?\n", i);
+    } else if (s->regs_init[i]) {
       fprintf(end_state, "x%ld:%lx\n", i, s->regs_values[i]);
     }
   }
+}
+
+static void echo_state_seed(state *s, FILE *end_state, uint32_t *seed) {
+  fprintf(end_state, "REGISTERS:\n");
+  if (seed != NULL) {
+    fprintf(end_state, "# seed %u\n", *seed);
+  }
+  echo_registers(s, end_state);
+  for (state *hart = s->next_hart; hart; hart = hart->next_hart) {
+    fprintf(end_state, "\nREGISTERS:\n");
+    echo_registers(hart, end_state);
+  }
   fprintf(end_state, "\nMEMORY:\n");
   uint64_t *addresses = get_initialised_adresses(s->memory);
   uint64_t n_printed_values = 0;
@@ -429,7 +614,7 @@ bool echo_and_kill_state_keep_seed(state *s, FILE *end_state, uint32_t *seed) {
     fprintf(end_state, "%lx: ", addresses[n_printed_values + 1]);
     space = false;
     uint8_t chain = 0;
-    for (size_t i = 0; i < 8; i++) {
+    for (size_t i = 0; i < 8 && n_printed_values + i < addresses[0]; i++) {
       if (i == addresses[n_printed_values + i + 1] -
                    addresses[n_printed_values + 1]) {
         chain++;
@@ -463,9 +648,23 @@ bool echo_and_kill_state_keep_seed(state *s, FILE *end_state, uint32_t *seed) {
     fprintf(end_state, "\n");
     n_printed_values += chain;
   }
+  for (size_t i = 0; i < s->n_symbolic_memory; i++) {
+    symbolic_range *range = &s->symbolic_memory[i];
+    fprintf(end_state, "%lx-%lx: ?", range->start, range->end);
+    if (range->min || range->max != 0xff) {
+      fprintf(end_state, " %x-%x", range->min, range->max);
+    }
+    fprintf(end_state, "\n");
+  }
   free(addresses);
-  kill_memory_table(s->memory);
-  free(s);
+}
 
+bool echo_state(state *s, FILE *end_state) {
+  echo_state_seed(s, end_state, NULL);
   return true;
+}
+
+bool echo_and_kill_state_keep_seed(state *s, FILE *end_state, uint32_t *seed) {
+  echo_state_seed(s, end_state, seed);
+  return kill_state(s);
 }
\ No newline at end of file
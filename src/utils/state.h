@@ -6,12 +6,31 @@
 #ifndef STATE
 #define STATE
 
+// Bytes the solver chooses, each one within [min, max]
+typedef struct symbolic_range {
+  uint64_t start;
+  uint64_t end; // inclusive
+  uint8_t min;
+  uint8_t max;
+} symbolic_range;
+
 typedef struct state {
   uint64_t pc;
   uint64_t regs_values[32];
   bool regs_init[32];
+  uint8_t xlen; // register width, 32 or 64
+
+  // Symbolic registers are initialised, their value lies in [min, max]
+  bool regs_symbolic[32];
+  uint64_t regs_min[32];
+  uint64_t regs_max[32];
 
   memory_table *memory;
+  symbolic_range *symbolic_memory;
+  size_t n_symbolic_memory;
+
+  // Further harts, each a state of its own registers on the same memory
+  struct state *next_hart;
 
 } state;
 
@@ -30,6 +49,10 @@ void set_word(state *s, uint64_t address, uint32_t value);
 void set_doubleword(state *s, uint64_t address, uint64_t value);
 void set_register(state *s, uint8_t register_number, uint64_t value);
 void set_pc(state *s, uint64_t value);
+void set_symbolic_register(state *s, uint8_t register_number, uint64_t min,
+                           uint64_t max);
+void add_symbolic_memory(state *s, uint64_t start, uint64_t end, uint8_t min,
+                         uint8_t max);
 void next_pc(state *s);
 
 bool pretty_print(state *s);
@@ -37,14 +60,28 @@ bool pretty_print(state *s);
 bool is_address_initialised(state *s, uint64_t address,
                             uint32_t hashed_address);
 bool is_register_initialised(state *s, uint8_t register_number);
+bool is_register_symbolic(state *s, uint8_t register_number);
+// Returns the range holding the address, NULL if its byte is concrete
+symbolic_range *find_symbolic_range(state *s, uint64_t address);
+bool has_symbolic_memory(state *s);
+
+// Appends a hart with uninitialised registers, hart 0 is the state itself
+state *create_hart(state *s);
+state *get_hart(state *s, size_t hart);
+size_t count_harts(state *s);
+void copy_registers(state *target, state *source);
 
 state *create_new_state();
 
 bool load_state(char *filename, state *s);
+bool load_state_stream(FILE *state_file, state *s);
+// The text of a state file, which does not need to end in '\0'
+bool load_state_buffer(const char *data, size_t length, state *s);
 
 bool kill_state(state *s);
 
 bool echo_and_kill_state(state *s, FILE *end_state);
+bool echo_state(state *s, FILE *end_state); // keeps the state
 bool echo_and_kill_state_keep_seed(state *s, FILE *target, uint32_t* seed);
 
 #endif // STATE
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "./template.h"
+#include "./writer.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void add_piece(model_template *t, size_t *capacity, size_t text,
+                      size_t end, template_slot slot, int value) {
+  if (t->n_pieces == *capacity) {
+    *capacity = *capacity ? 2 * *capacity : 1024;
+    t->pieces = realloc(t->pieces, *capacity * sizeof(template_piece));
+  }
+  template_piece *piece = &t->pieces[t->n_pieces++];
+  piece->text = text;
+  piece->length = end - text;
+  piece->slot = slot;
+  piece->value = value;
+}
+
+static void add_text(model_template *t, size_t *capacity, size_t text,
+                     size_t end, template_slot slot, int value) {
+  // Text up to end and the slot after it, marks in the text are names
+  char *mark = memchr(t->text + text, TEMPLATE_NAME_MARK[0], end - text);
+  while (mark) {
+    size_t at = mark - t->text;
+    add_piece(t, capacity, text, at, SLOT_NAME, 0);
+    text = at + 1;
+    mark = memchr(t->text + text, TEMPLATE_NAME_MARK[0], end - text);
+  }
+  add_piece(t, capacity, text, end, slot, value);
+}
+
+static bool is_digit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+static size_t read_number(const char *text, size_t at, size_t length,
+                          long *value) {
+  // Returns the end of the digits at at
+  *value = 0;
+  for (; at < length && is_digit(text[at]); at++) {
+    *value = 10 * *value + (text[at] - '0');
+  }
+  return at;
+}
+
+static size_t equal_prefix(const char *a, const char *b, size_t n) {
+  // Nearly all of both recordings is the same, so words are compared first
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= n; i += sizeof(uint64_t)) {
+    uint64_t a_word;
+    uint64_t b_word;
+    memcpy(&a_word, a + i, sizeof(a_word));
+    memcpy(&b_word, b + i, sizeof(b_word));
+    if (a_word != b_word) {
+      break;
+    }
+  }
+  for (; i < n && a[i] == b[i]; i++) {
+  }
+  return i;
+}
+
+model_template *compile_template(const char *key, char *a, size_t a_length,
+                                 char *b, size_t b_length, int n_lines) {
+  model_template *t = calloc(1, sizeof(model_template));
+  t->key = strdup(key);
+  t->text = a;
+  t->n_lines = n_lines;
+  size_t capacity = 0;
+  size_t done = 0; // text before is in pieces
+  size_t i = 0;
+  size_t j = 0;
+  bool valid = true;
+  while (valid) {
+    size_t left = a_length - i < b_length - j ? a_length - i : b_length - j;
+    size_t same = equal_prefix(a + i, b + j, left);
+    if (same == left) {
+      i += same;
+      j += same;
+      break;
+    }
+    // The numbers differ from their first digit on, back to it
+    for (; same > 0 && is_digit(a[i + same - 1]); same--) {
+    }
+    i += same;
+    j += same;
+    long a_value;
+    long b_value;
+    size_t a_end = read_number(a, i, a_length, &a_value);
+    size_t b_end = read_number(b, j, b_length, &b_value);
+    long line = a_value - TEMPLATE_LINES_A;
+    long input = a_value - TEMPLATE_INPUTS_A;
+    if (a_end == i || b_end == j) {
+      valid = false; // not a number that differs
+    } else if (b_value - a_value == TEMPLATE_LINES_B - TEMPLATE_LINES_A &&
+               line >= 0 && line < n_lines) {
+      add_text(t, &capacity, done, i, SLOT_LINE, line);
+    } else if (b_value - a_value == TEMPLATE_INPUTS_B - TEMPLATE_INPUTS_A &&
+               input >= 0 && input < TEMPLATE_INPUTS) {
+      add_text(t, &capacity, done, i, SLOT_INPUT, input);
+    } else {
+      valid = false;
+    }
+    done = a_end;
+    i = a_end;
+    j = b_end;
+  }
+  free(b);
+  if (!valid || i != a_length || j != b_length) {
+    kill_template(t);
+    return NULL;
+  }
+  add_text(t, &capacity, done, a_length, SLOT_END, 0);
+  return t;
+}
+
+int write_template(writer *w, model_template *t, int next_line,
+                   const int *inputs, const char *name) {
+  size_t name_length = strlen(name);
+  for (size_t i = 0; i < t->n_pieces; i++) {
+    template_piece *piece = &t->pieces[i];
+    const char *text = t->text + piece->text;
+    switch (piece->slot) {
+    case SLOT_LINE:
+      bwrite_text_number(w, text, piece->length, next_line + piece->value);
+      break;
+    case SLOT_INPUT:
+      bwrite_text_number(w, text, piece->length, inputs[piece->value]);
+      break;
+    case SLOT_NAME:
+      bwrite(w, text, piece->length);
+      bwrite(w, name, name_length);
+      break;
+    case SLOT_END:
+      bwrite(w, text, piece->length);
+      break;
+    }
+  }
+  return next_line + t->n_lines;
+}
+
+void kill_template(model_template *t) {
+  free(t->key);
+  free(t->text);
+  free(t->pieces);
+  free(t);
+}
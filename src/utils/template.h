@@ -0,0 +1,54 @@
+#include "./writer.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef TEMPLATE
+#define TEMPLATE
+
+// A template is recorded twice, its own lines and the ids that differ between
+// uses (inputs) start at other ids each time. A number that differs between
+// both is such an id, every other one is the same in each use.
+#define TEMPLATE_INPUTS 1024
+#define TEMPLATE_LINES_A (1 << 23)
+#define TEMPLATE_LINES_B (1 << 24)
+#define TEMPLATE_INPUTS_A (1 << 22)
+#define TEMPLATE_INPUTS_B ((1 << 22) + (1 << 21))
+#define TEMPLATE_NAME_MARK "\x01" // stands for the name prefix of symbols
+
+typedef enum template_slot {
+  SLOT_LINE,  // own line, moved with the template
+  SLOT_INPUT, // given with each use
+  SLOT_NAME,
+  SLOT_END
+} template_slot;
+
+// Text copied as it is, then the slot that is filled in after it
+typedef struct template_piece {
+  size_t text; // offset into the recorded text
+  size_t length;
+  template_slot slot;
+  int value; // line after the first one, or input index
+} template_piece;
+
+// A part of the model that is recorded once and written again at other ids
+typedef struct model_template {
+  char *key; // everything the recorded text depends on
+  char *text;
+  template_piece *pieces;
+  size_t n_pieces;
+  int n_lines;
+} model_template;
+
+// Takes both recordings of n_lines lines and the key they are valid for, a is
+// kept and b freed. Returns NULL if they differ in anything but the ids.
+model_template *compile_template(const char *key, char *a, size_t a_length,
+                                 char *b, size_t b_length, int n_lines);
+
+// Writes the template with its first line at next_line, inputs[i] for input
+// i and name for the mark in symbols. Returns the next free line.
+int write_template(writer *w, model_template *t, int next_line,
+                   const int *inputs, const char *name);
+
+void kill_template(model_template *t);
+
+#endif // TEMPLATE
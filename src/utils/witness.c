@@ -0,0 +1,333 @@
+// Needs btormc --trace-gen-full to function properly
+#include "./witness.h"
+#include "./state.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static FILE *select_prefix(FILE *witness_file, const char *prefix,
+                           bool with_shared, char **text) {
+  // Copies the state part at the file position with only the lines whose name
+  // starts with prefix, without it and numbered as if they were the only ones.
+  // The lines of no instance or hart, like the code memory, go last if shared.
+  // The copy is read from text, which the caller frees after closing it.
+  size_t length = 0;
+  char *shared_text = NULL;
+  size_t shared_length = 0;
+  FILE *selected = open_memstream(text, &length);
+  FILE *shared = open_memstream(&shared_text, &shared_length);
+  if (!selected || !shared) {
+    if (selected) {
+      fclose(selected);
+      free(*text);
+    }
+    if (shared) {
+      fclose(shared);
+      free(shared_text);
+    }
+    return NULL;
+  }
+  char buff[256];
+  long int last_id = -1;
+  long int new_id = 0;
+  while (fgets(buff, sizeof(buff), witness_file) != NULL &&
+         buff[0] != '@' && buff[0] != '#' && buff[0] != '.') {
+    char *rest = strchr(buff, ' ');
+    char *name = strrchr(buff, ' ');
+    if (!rest) {
+      continue;
+    }
+    name++;
+    if (!strncmp(name, "iterations_counter#", 19)) {
+      fputs(buff, selected);
+    } else if (!strncmp(name, prefix, strlen(prefix))) {
+      long int id = strtol(buff, NULL, 10);
+      if (id != last_id) {
+        last_id = id;
+        new_id++;
+      }
+      fprintf(selected, "%ld%.*s%s", new_id, (int)(name - rest), rest,
+              name + strlen(prefix));
+    } else if (with_shared && (name[0] != prefix[0] || !strchr(name, '.'))) {
+      fputs(buff, shared);
+    }
+  }
+  fclose(shared);
+  fwrite(shared_text, 1, shared_length, selected);
+  free(shared_text);
+  fclose(selected);
+  FILE *copy = fmemopen(*text, length, "r");
+  if (!copy) {
+    free(*text);
+  }
+  return copy;
+}
+
+static bool read_registers(FILE *witness_file, state *s) {
+  // Reads the registers, pc and initialisation flags of one hart
+  char buff[256];
+  char *token;
+
+  // A register file is printed as array lines "<id> [<index>] <value> <name>"
+  bool register_array = false;
+  long int after_registers = ftell(witness_file);
+  while (fgets(buff, sizeof(buff), witness_file) != NULL) {
+    char *name = strrchr(buff, ' ');
+    if (name && !strncmp(name + 1, "pc#", 3)) {
+      register_array = true; // no register was printed, all are zero
+      break;
+    }
+    token = strtok(buff, " ");
+    token = strtok(NULL, " ");
+    if (token == NULL || token[0] != '[') {
+      break;
+    }
+    register_array = true;
+    long int index = strtol(token + 1, NULL, 2);
+    char *value_str = strtok(NULL, " ");
+    token = strtok(NULL, " ");
+    size_t value_length = value_str ? strlen(value_str) : 0;
+    if ((value_length != 32 && value_length != 64) || token == NULL) {
+      fprintf(stderr, "Invalid register file line format: %s", buff);
+      return false;
+    }
+    // initial_registers only holds the values before the first step
+    if (!strncmp(token, "registers", 9) && index != 0) {
+      set_register(s, index, strtoull(value_str, NULL, 2));
+    }
+    s->xlen = value_length;
+    after_registers = ftell(witness_file);
+  }
+  fseek(witness_file, after_registers, SEEK_SET);
+
+  for (int i = 1; i <= 32 && !register_array; i++) {
+    fgets(buff, sizeof(buff), witness_file);
+    token = strtok(buff, " ");
+    char id_str[8];           // Buffer for ID string
+    sprintf(id_str, "%d", i); // Convert i to string
+    if (token == NULL || strcmp(token, id_str) != 0) {
+      fprintf(stderr,
+              "Invalid state part format. Expected ID %d for assignment of "
+              "x%d, got: %s\n",
+              i, i - 1, buff);
+      return false;
+    }
+    token = strtok(NULL, " ");
+    if (token == NULL ||
+        (strlen(token) != 32 && strlen(token) != 64)) { // RV32 or RV64
+      fprintf(stderr,
+              "Invalid state part format. Expected valid 32 or 64bit binary "
+              "register value "
+              "for x%d, got: %s\nwith length of %d\n",
+              i - 1, token, token ? (int)strlen(token) : 0);
+      return false;
+    }
+    set_register(s, i - 1,
+                 strtoull(token, NULL, 2)); // Convert binary string to long int
+    s->xlen = strlen(token);
+  }
+  fgets(buff, sizeof(buff), witness_file); // This should be pc
+  token = strtok(buff, " ");
+  token = strtok(NULL, " "); // Skip the ID part
+  char *pc_value_str = token;
+  token = strtok(NULL, " ");
+  if (token == NULL || strncmp(token, "pc", 2) != 0) {
+    fprintf(stderr,
+            "Invalid state part format. Expected pc assignment, got:\n%s",
+            buff);
+    return false;
+  }
+  set_pc(s, strtol(pc_value_str, NULL, 2)); // Convert binary string to long int
+
+  // Read the initialisation flags
+  for (int i = 0; i < 32; i++) {
+    fgets(buff, sizeof(buff), witness_file);
+    token = strtok(buff, " "); // ID
+    token = strtok(NULL, " ");
+    if (token == NULL || strlen(token) != 1) { // flags
+      fprintf(stderr,
+              "Invalid state part format. Expected flag "
+              "for x%d, got: %s\n",
+              i, token);
+      return false;
+    }
+    s->regs_init[i] = (token[0] == '1'); // Convert to boolean
+  }
+  return true;
+}
+
+static state *parse_state_part(FILE *witness_file) {
+  // The state part at the file position, after its '#' line
+  char buff[256]; // Buffer for reading lines. Size is plenty for this use case.
+                  // 74 are needed at mosst for up to 99 iterations
+  char *buff_ptr = buff; // Pointer to the buffer
+  long int part_start = ftell(witness_file);
+  buff_ptr = fgets(buff, sizeof(buff), witness_file); // Skip iterations counter
+  if (buff_ptr && (strncmp(buff, "0 ", 2) ||
+                   strncmp(buff + 66, " iterations_counter#", 20))) {
+    fprintf(stderr,
+            "Invalid state part format. Expected iterations counter, got:\n%s",
+            buff);
+    return NULL;
+  }
+
+  // Read the state part
+  state *s = create_new_state();
+  char *token;
+  if (!read_registers(witness_file, s)) {
+    kill_state(s);
+    return NULL;
+  }
+
+  // Read memory values
+  while (fgets(buff, sizeof(buff), witness_file) != NULL && buff[0] != '@') {
+    if (buff[0] == '\n') {
+      fprintf(stderr, "Unexpected empty line in memory section.\n");
+      kill_state(s);
+      return NULL;
+    }
+    char *name = strrchr(buff, ' ');
+    if (name && strncmp(name + 1, "memory", 6)) {
+      continue; // registers of the other harts and the scheduler states
+    }
+    token = strtok(buff, " ");
+    if (token == NULL) {
+      fprintf(stderr, "Invalid memory line format: %s", buff);
+      kill_state(s);
+      return NULL;
+    }
+    token = strtok(NULL, " ");
+    // Scalar memory has a state per byte, named by its hex address
+    char *cell_name =
+        token && token[0] != '[' ? strtok(NULL, " ") : NULL;
+    if (cell_name && strlen(token) == 8 &&
+        !strncmp(cell_name, "memory_", 7)) {
+      set_byte(s, strtoull(cell_name + 7, NULL, 16),
+               strtoull(token, NULL, 2));
+      continue;
+    }
+    if (token == NULL || token[0] != '[' || token[strlen(token) - 1] != ']') {
+      fprintf(
+          stderr,
+          "Invalid memory line format, address format expects '[]', got: %s\n",
+          token);
+      fprintf(stderr, "In following line: %s", buff);
+      kill_state(s);
+      return NULL;
+    }
+    token++;                                   // Skip the '['
+    long int address = strtol(token, NULL, 2); // Convert hex string to long int
+
+    token = strtok(NULL, " ");
+    size_t value_length = token ? strlen(token) : 0;
+    if (token == NULL ||
+        (value_length != 8 && value_length != 32 &&
+         value_length != 64)) { // byte, word or double word memory cells
+      fprintf(stderr, "Invalid memory value format for address %s: %s", token,
+              buff);
+      kill_state(s);
+      return NULL;
+    }
+
+    uint64_t value =
+        strtoull(token, NULL, 2); // Convert binary string to long int
+
+    token = strtok(NULL, " ");
+    if (token == NULL || strncmp(token, "memory", 6) != 0) {
+      fprintf(stderr,
+              "Invalid memory line format. Expected 'memory' name, got: %s at "
+              "address %lx (hex)\n",
+              token, address);
+      kill_state(s);
+      return NULL;
+    }
+
+    // Word addressed memory is indexed by cell, bytes are little endian
+    int cell_bytes = value_length / 8;
+    for (int i = 0; i < cell_bytes; i++) {
+      set_byte(s, address * cell_bytes + i, value >> (8 * i));
+    }
+  }
+
+  // Every further hart has its registers prefixed by "h<hart>."
+  for (int hart = 1;; hart++) {
+    char prefix[16];
+    snprintf(prefix, sizeof(prefix), "h%d.", hart);
+    fseek(witness_file, part_start, SEEK_SET);
+    char *text;
+    FILE *selected = select_prefix(witness_file, prefix, false, &text);
+    if (!selected) {
+      fprintf(stderr, "Failed to select the registers of the hart.\n");
+      kill_state(s);
+      return NULL;
+    }
+    fgets(buff, sizeof(buff), selected); // iterations counter
+    long int registers_start = ftell(selected);
+    if (fgets(buff, sizeof(buff), selected) == NULL) {
+      fclose(selected);
+      free(text);
+      break;
+    }
+    fseek(selected, registers_start, SEEK_SET);
+    bool valid = read_registers(selected, create_hart(s));
+    fclose(selected);
+    free(text);
+    if (!valid) {
+      kill_state(s);
+      return NULL;
+    }
+  }
+  return s;
+}
+
+state *parse_witness(FILE *witness_file, int instance, bool first_state) {
+  char buff[256];
+  long int last_state_part = -1;
+
+  while (fgets(buff, sizeof(buff), witness_file) != NULL) {
+    if (buff[0] != '#') {
+      continue; // Only find starts of state_part
+    } else {
+      // Save the position of the last state part
+      last_state_part = ftell(witness_file);
+      if (first_state) {
+        break;
+      }
+    }
+  }
+  if (last_state_part == -1) {
+    fprintf(stderr, "No state part found in witness file.\n");
+    return NULL;
+  }
+  // Reset the file pointer to the last state part
+  fseek(witness_file, last_state_part, SEEK_SET);
+  if (instance < 0) {
+    return parse_state_part(witness_file);
+  }
+  char prefix[16];
+  snprintf(prefix, sizeof(prefix), "i%d.", instance);
+  char *text;
+  FILE *selected = select_prefix(witness_file, prefix, true, &text);
+  if (!selected) {
+    fprintf(stderr, "Failed to select the lines of the instance.\n");
+    return NULL;
+  }
+  state *s = parse_state_part(selected);
+  fclose(selected);
+  free(text);
+  return s;
+}
+
+state *parse_witness_buffer(const char *data, size_t length, int instance,
+                            bool first_state) {
+  FILE *witness_file = fmemopen((void *)data, length, "r");
+  if (!witness_file) {
+    fprintf(stderr, "Failed to read the witness.\n");
+    return NULL;
+  }
+  state *s = parse_witness(witness_file, instance, first_state);
+  fclose(witness_file);
+  return s;
+}
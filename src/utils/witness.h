@@ -0,0 +1,19 @@
+#include "./state.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+#ifndef WITNESS
+#define WITNESS
+
+// Reads the state a btormc witness ends in, it needs --trace-gen-full. With
+// first_state it is the initial one the solver chose instead. With an
+// instance >= 0 that instance of a multi-instance model is read, the code
+// memory they share included. Returns NULL with a message on stderr if the
+// witness has no valid state part.
+state *parse_witness(FILE *witness_file, int instance, bool first_state);
+
+// The same on the text of a witness, which does not need to end in '\0'
+state *parse_witness_buffer(const char *data, size_t length, int instance,
+                            bool first_state);
+
+#endif // WITNESS
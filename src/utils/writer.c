@@ -0,0 +1,294 @@
+#include "./writer.h"
+#include <errno.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static writer *new_writer(int fd, size_t size) {
+  writer *w = malloc(sizeof(writer));
+  if (!w) {
+    return NULL;
+  }
+  w->buffer = malloc(size);
+  if (!w->buffer) {
+    free(w);
+    return NULL;
+  }
+  w->fd = fd;
+  w->sink = NULL;
+  w->context = NULL;
+  w->size = size;
+  w->used = 0;
+  w->failed = false;
+  return w;
+}
+
+writer *open_writer(int fd) {
+  return new_writer(fd, WRITER_BUFFER_SIZE);
+}
+
+writer *open_memory_writer(void) {
+  return new_writer(-1, WRITER_BUFFER_SIZE / 16); // grows when needed
+}
+
+writer *open_sink_writer(writer_sink sink, void *context) {
+  writer *w = new_writer(-1, WRITER_BUFFER_SIZE / 16);
+  if (w) {
+    w->sink = sink;
+    w->context = context;
+  }
+  return w;
+}
+
+static bool is_memory_writer(writer *w) {
+  return w->fd < 0 && !w->sink;
+}
+
+static void write_all(writer *w, const char *data, size_t n) {
+  if (w->sink) {
+    if (n && !w->failed && !w->sink(w->context, data, n)) {
+      w->failed = true;
+    }
+    return;
+  }
+  while (n && !w->failed) {
+    ssize_t written = write(w->fd, data, n);
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    if (written <= 0) {
+      w->failed = true;
+      break;
+    }
+    data += written;
+    n -= written;
+  }
+}
+
+static void flush_writer(writer *w) {
+  write_all(w, w->buffer, w->used);
+  w->used = 0;
+}
+
+static bool grow_writer(writer *w, size_t n) {
+  // A memory writer keeps everything, so the buffer doubles instead
+  size_t size = w->size;
+  while (size - w->used < n) {
+    size *= 2;
+  }
+  char *buffer = realloc(w->buffer, size);
+  if (!buffer) {
+    w->failed = true;
+    return false;
+  }
+  w->buffer = buffer;
+  w->size = size;
+  return true;
+}
+
+void bwrite(writer *w, const char *data, size_t n) {
+  if (n > w->size - w->used) {
+    if (is_memory_writer(w)) {
+      if (!grow_writer(w, n)) {
+        return;
+      }
+    } else {
+      flush_writer(w);
+      if (n >= w->size) {
+        write_all(w, data, n); // would not fit anyway
+        return;
+      }
+    }
+  }
+  memcpy(w->buffer + w->used, data, n);
+  w->used += n;
+}
+
+// Digits of value are written backwards from end, returns the first one
+static char *format_unsigned(char *end, uint64_t value, int base) {
+  static const char pairs[] = "00010203040506070809"
+                              "10111213141516171819"
+                              "20212223242526272829"
+                              "30313233343536373839"
+                              "40414243444546474849"
+                              "50515253545556575859"
+                              "60616263646566676869"
+                              "70717273747576777879"
+                              "80818283848586878889"
+                              "90919293949596979899";
+  if (base == 16) {
+    do {
+      *--end = "0123456789abcdef"[value & 0xf];
+      value >>= 4;
+    } while (value);
+    return end;
+  }
+  while (value >= 100) {
+    const char *pair = pairs + 2 * (value % 100);
+    value /= 100;
+    *--end = pair[1];
+    *--end = pair[0];
+  }
+  if (value >= 10) {
+    *--end = pairs[2 * value + 1];
+    *--end = pairs[2 * value];
+  } else {
+    *--end = '0' + value;
+  }
+  return end;
+}
+
+static void write_number(writer *w, uint64_t magnitude, bool negative,
+                         int base, int width, char pad) {
+  char text[24];
+  char *end = text + sizeof(text);
+  char *start = format_unsigned(end, magnitude, base);
+  if (negative) {
+    *--start = '-';
+  }
+  int length = end - start;
+  if (width > length) { // only for %08x, the slow way is fine
+    if (negative && pad == '0') {
+      bwrite(w, start++, 1);
+    }
+    for (; length < width; length++) {
+      bwrite(w, &pad, 1);
+    }
+  }
+  bwrite(w, start, end - start);
+}
+
+void bwrite_number(writer *w, long value) {
+  uint64_t magnitude = value < 0 ? -(uint64_t)value : (uint64_t)value;
+  write_number(w, magnitude, value < 0, 10, 0, ' ');
+}
+
+void bwrite_file(writer *w, FILE *source) {
+  char chunk[1 << 16];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), source)) > 0) {
+    bwrite(w, chunk, n);
+  }
+  if (ferror(source)) {
+    w->failed = true;
+  }
+}
+
+void bwrite_text_number(writer *w, const char *data, size_t n, long value) {
+  // bwrite and bwrite_number at once, the copy goes straight to the buffer
+  if (n + 24 > w->size - w->used) {
+    bwrite(w, data, n);
+    bwrite_number(w, value);
+    return;
+  }
+  memcpy(w->buffer + w->used, data, n);
+  w->used += n;
+  char text[24];
+  char *end = text + sizeof(text);
+  uint64_t magnitude = value < 0 ? -(uint64_t)value : (uint64_t)value;
+  char *start = format_unsigned(end, magnitude, 10);
+  if (value < 0) {
+    *--start = '-';
+  }
+  memcpy(w->buffer + w->used, start, end - start);
+  w->used += end - start;
+}
+
+void bprintf(writer *w, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  const char *c = format;
+  while (*c) {
+    // Text up to the next conversion goes straight into the buffer
+    char *out = w->buffer + w->used;
+    char *limit = w->buffer + w->size;
+    while (*c && *c != '%') {
+      if (out == limit) {
+        w->used = w->size;
+        if (!is_memory_writer(w)) {
+          flush_writer(w);
+        } else if (!grow_writer(w, 1)) {
+          w->used = 0; // dropped, it failed
+        }
+        out = w->buffer + w->used;
+        limit = w->buffer + w->size;
+      }
+      *out++ = *c++;
+    }
+    w->used = out - w->buffer;
+    if (!*c) {
+      break;
+    }
+    c++;
+    char pad = ' ';
+    if (*c == '0') {
+      pad = '0';
+      c++;
+    }
+    int width = 0;
+    for (; *c >= '0' && *c <= '9'; c++) {
+      width = 10 * width + (*c - '0');
+    }
+    bool is_long = *c == 'l';
+    if (is_long) {
+      c++;
+    }
+    switch (*c) {
+    case 'd': {
+      int64_t value = is_long ? va_arg(args, long) : va_arg(args, int);
+      uint64_t magnitude = value < 0 ? -(uint64_t)value : (uint64_t)value;
+      write_number(w, magnitude, value < 0, 10, width, pad);
+      break;
+    }
+    case 'u':
+    case 'x': {
+      uint64_t value = is_long ? va_arg(args, unsigned long)
+                               : va_arg(args, unsigned int);
+      write_number(w, value, false, *c == 'u' ? 10 : 16, width, pad);
+      break;
+    }
+    case 's': {
+      const char *text = va_arg(args, const char *);
+      bwrite(w, text, strlen(text));
+      break;
+    }
+    case 'c': {
+      char character = va_arg(args, int);
+      bwrite(w, &character, 1);
+      break;
+    }
+    case '%':
+      bwrite(w, "%", 1);
+      break;
+    default:
+      c--; // not supported, the rest is copied as it is
+      break;
+    }
+    c++;
+  }
+  va_end(args);
+}
+
+char *take_writer_buffer(writer *w, size_t *n) {
+  char *buffer = w->failed ? NULL : w->buffer;
+  *n = w->used;
+  if (!buffer) {
+    free(w->buffer);
+  }
+  free(w);
+  return buffer;
+}
+
+int close_writer(writer *w) {
+  if (!is_memory_writer(w)) {
+    flush_writer(w);
+  }
+  bool failed = w->failed;
+  free(w->buffer);
+  free(w);
+  return failed ? -1 : 0;
+}
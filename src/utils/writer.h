@@ -0,0 +1,53 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#ifndef WRITER
+#define WRITER
+
+#define WRITER_BUFFER_SIZE (1 << 20) // bytes collected before a write
+
+// Output collected in a large buffer and written to a file descriptor in
+// few write calls, which is what the millions of model lines need. Instead it
+// can be handed to a sink, or without either the buffer grows and keeps all.
+typedef bool (*writer_sink)(void *context, const char *data, size_t n);
+
+typedef struct writer {
+  int fd; // -1 for a memory writer or a sink
+  writer_sink sink; // returns false if the data could not be taken
+  void *context;
+  char *buffer;
+  size_t size;
+  size_t used;
+  bool failed; // a write did not go through, the rest is dropped
+} writer;
+
+// Returns NULL if the buffer could not be allocated
+writer *open_writer(int fd);
+
+writer *open_memory_writer(void);
+
+writer *open_sink_writer(writer_sink sink, void *context);
+
+void bwrite(writer *w, const char *data, size_t n);
+
+void bwrite_number(writer *w, long value); // in decimal
+
+void bwrite_file(writer *w, FILE *source); // the rest of source
+
+void bwrite_text_number(writer *w, const char *data, size_t n, long value);
+
+// Formats like fprintf, but only %d, %u, %x, %s, %c and %% with an optional
+// 'l' and zero padded width. Integers are converted by hand.
+void bprintf(writer *w, const char *format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+// Frees a memory writer and returns what it collected, NULL if that failed.
+// The caller frees it.
+char *take_writer_buffer(writer *w, size_t *n);
+
+// Writes what is left and frees w, the descriptor stays open.
+// Returns -1 if any write failed.
+int close_writer(writer *w);
+
+#endif // WRITER